@@ -1,5 +1,168 @@
 #include "analex.h"
+#include "afd_tabela.h" // Gerado por gera_afd a partir de AFD/afd.jff
+#include "potencias_cinco.h"
+#include <limits.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#include <stdint.h>
+#endif
+
+#define TAM_BLOCO_LEITURA (64 * 1024) // Tamanho de cada leitura quando a fonte não pode ser mapeada
+#define TAM_TEXTO_ARQUIVO (2 * TAM_NUM + 4) // Maior lexema com limite de tamanho (real: parte inteira + '.' + parte decimal)
+#ifndef TAM_MIN_PARALELO
+#define TAM_MIN_PARALELO (1024 * 1024) // Abaixo disso, pre_analex_paralelo lê a fonte sem threads
+#endif
+#define MAX_THREADS_ANALEX 64             // Máximo de trechos lidos ao mesmo tempo por pre_analex_paralelo
+
+/* 
+    Buffer com o código-fonte inteiro, percorrido por um cursor.
+    Quando 'ativa' é false, o Analex usa o caminho antigo (fgetc/ungetc).
+*/
+static struct 
+{
+    bool ativa;         // true depois de um carregar_fonte bem-sucedido
+    bool mapeada;       // true se o buffer veio de mmap (senão, de malloc)
+    const char *base;   // Início do buffer
+    size_t tam_base;    // Tamanho total do buffer (para munmap/free)
+    const char *cursor; // Próximo caractere a ser lido
+    const char *fim;    // Um após o último caractere válido
+} fonte;
+
+/* 
+    Varredura vetorizada das repetições longas do AFD (brancos em q0, corpo de comentário em q44
+    e corpo de string em q15). Cada bloco de 32 (AVX2) ou 16 (SSE2) bytes vira uma máscara de bits:
+    o primeiro caractere que sai da repetição é achado com ctz e as quebras de linha são contadas
+    com popcount. Sem SSE2/AVX2 (ou compilando para outra arquitetura) fica só o laço escalar.
+    Para usar AVX2, compile com -mavx2 (ou -march=native).
+*/
+#if defined(__AVX2__)
+typedef __m256i VETOR;
+#define TAM_VETOR 32
+#define MASCARA_CHEIA 0xFFFFFFFFu
+#define CARREGA(p) _mm256_loadu_si256((const __m256i *)(p))
+#define IGUAL(v, c) _mm256_cmpeq_epi8((v), _mm256_set1_epi8(c))
+#define MENOR(v, c) _mm256_cmpgt_epi8(_mm256_set1_epi8(c), (v)) // Comparação com sinal: bytes >= 0x80 também são "menores"
+#define OU(a, b) _mm256_or_si256((a), (b))
+#define MASCARA(v) ((uint32_t)_mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+typedef __m128i VETOR;
+#define TAM_VETOR 16
+#define MASCARA_CHEIA 0xFFFFu
+#define CARREGA(p) _mm_loadu_si128((const __m128i *)(p))
+#define IGUAL(v, c) _mm_cmpeq_epi8((v), _mm_set1_epi8(c))
+#define MENOR(v, c) _mm_cmplt_epi8((v), _mm_set1_epi8(c))
+#define OU(a, b) _mm_or_si128((a), (b))
+#define MASCARA(v) ((uint32_t)_mm_movemask_epi8(v))
+#endif
+
+/* Caracteres que repetem cada estado (devem ser os mesmos laços do diagrama; conferido em confere_pulos) */
+static inline bool eh_branco(unsigned char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static inline bool eh_corpo_comentario(unsigned char c) { return c != '*'; }
+static inline bool eh_corpo_string(unsigned char c) { return (c >= 0x20 && c < 0x7F && c != '"' && c != '\\') || c == '\r'; }
+
+/* Avança sobre brancos a partir de 'p', somando as quebras de linha em '*linha' */
+static const char *pula_brancos(const char *p, const char *fim, int *linha)
+{
+#ifdef TAM_VETOR
+    while (fim - p >= TAM_VETOR)
+    {
+        VETOR v = CARREGA(p);
+        VETOR quebra = IGUAL(v, '\n');
+        uint32_t brancos = MASCARA(OU(OU(IGUAL(v, ' '), IGUAL(v, '\t')), OU(IGUAL(v, '\r'), quebra)));
+        uint32_t quebras = MASCARA(quebra);
+        if (brancos != MASCARA_CHEIA)
+        {
+            int k = __builtin_ctz(~brancos);
+            *linha += __builtin_popcount(quebras & ((1u << k) - 1));
+            return p + k;
+        }
+        *linha += __builtin_popcount(quebras);
+        p += TAM_VETOR;
+    }
+#endif
+    while (p < fim && eh_branco((unsigned char)*p))
+    {
+        *linha += (*p == '\n');
+        p++;
+    }
+    return p;
+}
+
+/* Avança sobre o corpo de um comentário até o próximo '*', somando as quebras de linha em '*linha' */
+static const char *pula_comentario(const char *p, const char *fim, int *linha)
+{
+#ifdef TAM_VETOR
+    while (fim - p >= TAM_VETOR)
+    {
+        VETOR v = CARREGA(p);
+        uint32_t asteriscos = MASCARA(IGUAL(v, '*'));
+        uint32_t quebras = MASCARA(IGUAL(v, '\n'));
+        if (asteriscos != 0)
+        {
+            int k = __builtin_ctz(asteriscos);
+            *linha += __builtin_popcount(quebras & ((1u << k) - 1));
+            return p + k;
+        }
+        *linha += __builtin_popcount(quebras);
+        p += TAM_VETOR;
+    }
+#endif
+    while (p < fim && eh_corpo_comentario((unsigned char)*p))
+    {
+        *linha += (*p == '\n');
+        p++;
+    }
+    return p;
+}
+
+/* Avança sobre o corpo de uma string até aspas, barra invertida ou caractere não imprimível (que não pode ser quebra de linha) */
+static const char *pula_string(const char *p, const char *fim)
+{
+#ifdef TAM_VETOR
+    while (fim - p >= TAM_VETOR)
+    {
+        VETOR v = CARREGA(p);
+        VETOR ruins = OU(OU(MENOR(v, 0x20), IGUAL(v, 0x7F)), OU(IGUAL(v, '"'), IGUAL(v, '\\')));
+        uint32_t paradas = MASCARA(ruins) & ~MASCARA(IGUAL(v, '\r'));
+        if (paradas != 0)
+        {
+            return p + __builtin_ctz(paradas);
+        }
+        p += TAM_VETOR;
+    }
+#endif
+    while (p < fim && eh_corpo_string((unsigned char)*p)) p++;
+    return p;
+}
+
+/* 
+    Os pulos só podem ser usados se fizerem exatamente o que o diagrama faz nesses estados.
+    Na primeira chamada do Analex, cada byte é conferido contra a tabela gerada; se o diagrama
+    mudar e deixar de bater, os pulos são desligados e o AFD segue caractere a caractere.
+*/
+static bool pulos_conferidos = false;
+static bool pulos_ativos = false;
+
+static void confere_pulos()
+{
+    pulos_conferidos = true;
+    for (int c = 0; c < 256; c++)
+    {
+        int classe = afd_classe[c];
+        if (eh_branco(c) != (afd_transicao[AFD_Q0][classe] == AFD_Q0)) return;
+        if (eh_corpo_comentario(c) != (afd_transicao[AFD_Q44][classe] == AFD_Q44)) return;
+        if (eh_corpo_string(c) != (afd_transicao[AFD_Q15][classe] == AFD_Q15)) return;
+    }
+    pulos_ativos = true;
+}
 
 void error(char msg[]) 
 {
@@ -22,878 +185,1010 @@ bool is_printable_ascii(char c)
     return isprint(c);
 }
 
-int check_reserved_word(const char *lexema) 
+void copia_lexema(const TOKEN *tk, char *destino, int tam_destino)
 {
-    if (strcmp(lexema, "if") == 0)
+    int n = tk->tamanho < tam_destino - 1 ? tk->tamanho : tam_destino - 1;
+    memcpy(destino, tk->inicio, n);
+    destino[n] = '\0';
+}
+
+bool carregar_fonte(FILE *fd)
+{
+    liberar_fonte();
+
+    long inicio = ftell(fd);
+    if (inicio < 0) inicio = 0;
+
+#ifndef _WIN32
+    // Arquivo regular: mapeia o arquivo inteiro, sem cópia
+    struct stat st;
+    if (fstat(fileno(fd), &st) == 0 && S_ISREG(st.st_mode))
+    {
+        if (st.st_size == 0 || inicio >= st.st_size)
+        {
+            fonte.base = "";
+            fonte.tam_base = 0;
+            fonte.cursor = fonte.fim = fonte.base;
+            fonte.ativa = true;
+            return true;
+        }
+        void *mapa = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(fd), 0);
+        if (mapa != MAP_FAILED)
+        {
+            madvise(mapa, (size_t)st.st_size, MADV_SEQUENTIAL);
+            fonte.base = mapa;
+            fonte.tam_base = (size_t)st.st_size;
+            fonte.cursor = fonte.base + inicio;
+            fonte.fim = fonte.base + st.st_size;
+            fonte.mapeada = true;
+            fonte.ativa = true;
+            return true;
+        }
+    }
+#endif
+
+    // Pipe, terminal ou falha no mmap: lê tudo em blocos grandes para um buffer que cresce
+    size_t capacidade = TAM_BLOCO_LEITURA;
+    size_t usado = 0;
+    char *buffer = malloc(capacidade);
+    if (buffer == NULL) return false;
+
+    size_t lidos;
+    while ((lidos = fread(buffer + usado, 1, capacidade - usado, fd)) > 0)
     {
-        return PR_IF;
-    } 
-    if (strcmp(lexema, "else") == 0)
+        usado += lidos;
+        if (usado == capacidade)
+        {
+            char *maior = realloc(buffer, capacidade * 2);
+            if (maior == NULL)
+            {
+                free(buffer);
+                return false;
+            }
+            buffer = maior;
+            capacidade *= 2;
+        }
+    }
+
+    fonte.base = buffer;
+    fonte.tam_base = capacidade;
+    fonte.cursor = buffer;
+    fonte.fim = buffer + usado;
+    fonte.mapeada = false;
+    fonte.ativa = true;
+    return true;
+}
+
+void liberar_fonte()
+{
+    if (!fonte.ativa) return;
+#ifndef _WIN32
+    if (fonte.mapeada)
     {
-        return PR_ELSE;
+        munmap((void *)fonte.base, fonte.tam_base);
     }
-    if (strcmp(lexema, "while") == 0)
+    else
+#endif
+    if (fonte.tam_base > 0)
     {
-        return PR_WHILE;
+        free((void *)fonte.base);
     }
-    if (strcmp(lexema, "for") == 0)
+    memset(&fonte, 0, sizeof(fonte));
+}
+
+/* 
+    Palavras reservadas indexadas por um hash perfeito sobre a primeira letra, a última letra e o tamanho.
+    As 16 palavras caem em posições distintas da tabela de 32 entradas, então reconhecer uma palavra
+    custa um cálculo e uma única comparação. Ao incluir uma palavra nova, confira que ela não colide
+    com nenhuma posição já ocupada (o compilador avisa sobre inicializadores repetidos com -Wextra).
+*/
+#define HASH_PR(primeira, ultima, tamanho) ((3 * (primeira) + 2 * (ultima) + (tamanho)) & 31)
+
+static const struct 
+{
+    const char *palavra;
+    int tamanho;
+    int codigo;
+} palavras_reservadas[32] = 
+{
+    [HASH_PR('i', 'f', 2)] = { "if", 2, PR_IF },
+    [HASH_PR('e', 'e', 4)] = { "else", 4, PR_ELSE },
+    [HASH_PR('w', 'e', 5)] = { "while", 5, PR_WHILE },
+    [HASH_PR('f', 'r', 3)] = { "for", 3, PR_FOR },
+    [HASH_PR('r', 'n', 6)] = { "return", 6, PR_RETURN },
+    [HASH_PR('i', 't', 3)] = { "int", 3, PR_INTCON },
+    [HASH_PR('r', 'l', 4)] = { "real", 4, PR_REALCON },
+    [HASH_PR('c', 'r', 4)] = { "char", 4, PR_CHARCON },
+    [HASH_PR('s', 'g', 6)] = { "string", 6, PR_STRINGCON },
+    [HASH_PR('b', 'k', 5)] = { "break", 5, PR_BREAK },
+    [HASH_PR('c', 'e', 8)] = { "continue", 8, PR_CONTINUE },
+    [HASH_PR('v', 'd', 4)] = { "void", 4, PR_VOID },
+    [HASH_PR('b', 'l', 4)] = { "bool", 4, PR_BOOL },
+    [HASH_PR('f', 't', 5)] = { "float", 5, PR_FLOAT },
+    [HASH_PR('d', 'e', 6)] = { "double", 6, PR_DOUBLE },
+    [HASH_PR('d', 'o', 2)] = { "do", 2, PR_DO },
+};
+
+int check_reserved_span(const char *inicio, int tamanho)
+{
+    // Palavras reservadas têm de 2 ("if", "do") a 8 ("continue") letras
+    if (tamanho < 2 || tamanho > 8) return 0;
+
+    int h = HASH_PR((unsigned char)inicio[0], (unsigned char)inicio[tamanho - 1], tamanho);
+    if (palavras_reservadas[h].tamanho == tamanho && memcmp(palavras_reservadas[h].palavra, inicio, tamanho) == 0)
     {
-        return PR_FOR;
-    } 
-    if (strcmp(lexema, "return") == 0)
+        return palavras_reservadas[h].codigo;
+    }
+    return 0; // Não é palavra reservada
+}
+
+int check_reserved_word(const char *lexema) 
+{
+    return check_reserved_span(lexema, (int)strlen(lexema));
+}
+
+/* 
+    Aponta o erro léxico de uma transição que não existe no AFD.
+    A mensagem depende do estado onde o AFD parou e do caractere que não pôde ser lido.
+*/
+static void erro_lexico(int estado, int c)
+{
+    char msg_err[100];
+
+    switch (estado)
     {
-        return PR_RETURN;
-    } 
-    if (strcmp(lexema, "int") == 0)
+        // Após o primeiro apóstrofo
+        case AFD_Q2:
+            if (c == EOF) error("Constante de caractere nao fechada (EOF atingido).");
+            if (c == '\'') error("Aspas simples vazias não são permitidas.");
+            sprintf(msg_err, "Caracter '%c' invalido em constante de caractere.", c);
+            break;
+        // Após o caractere (ou escape) de um charcon, esperando o apóstrofo de fechamento
+        case AFD_Q4:
+        case AFD_Q7:
+        case AFD_Q8:
+            if (c == EOF) error("Constante de caractere nao fechada (EOF atingido).");
+            sprintf(msg_err, "Constante de caractere mal formada: esperado 'c'.");
+            break;
+        // Após a barra invertida de um charcon: só existem \n e \0
+        case AFD_Q6:
+            if (c == EOF) error("Constante de caractere nao fechada: EOF apos escape. \\0 ou \\n");
+            sprintf(msg_err, "Sequencia de escape '\\%c' invalida.", c);
+            break;
+        // Após o ponto de uma constante real
+        case AFD_Q13:
+            if (c == EOF) error("Constante real mal formada: EOF apos o ponto.");
+            sprintf(msg_err, "Constante real mal formada: esperado digito apos o ponto.");
+            break;
+        // Dentro de uma stringcon
+        case AFD_Q15:
+            if (c == EOF) error("Constante de string nao fechada (EOF atingido).");
+            if (c == '\n') error("Constante de string contem quebra de linha nao escapada.");
+            sprintf(msg_err, "Caracter '%c' invalido em constante de string.", c);
+            break;
+        // Após a barra invertida de uma stringcon: só existem \n e \"
+        case AFD_Q49:
+            if (c == EOF) error("Constante de string nao fechada: EOF apos escape.");
+            sprintf(msg_err, "Sequencia de escape '\\%c' invalida em string.", c);
+            break;
+        // Dentro de um comentário
+        case AFD_Q44:
+        case AFD_Q45:
+            sprintf(msg_err, "Comentario nao fechado (EOF atingido).");
+            break;
+        case AFD_Q38:
+            sprintf(msg_err, "Caracter invalido: '&' deve ser seguido por '&'.");
+            break;
+        case AFD_Q40:
+            sprintf(msg_err, "Caracter invalido: '|' deve ser seguido por '|'.");
+            break;
+        default:
+            sprintf(msg_err, "Caracter '%c' invalido.", c);
+            break;
+    }
+    error(msg_err);
+}
+
+/* 
+    Conversão das constantes numéricas direto do texto lido pelo AFD, sem cópia e sem atoi/atof.
+    O AFD já garantiu que o texto só tem dígitos (e um ponto, no real), então basta uma passada.
+*/
+
+/* Converte uma constante inteira; false se o valor não couber em um int */
+static bool converte_inteiro(const char *texto, int n, int *valor)
+{
+    int v = 0;
+    for (int i = 0; i < n; i++)
     {
-        return PR_INTCON;
-    } 
-    if (strcmp(lexema, "real") == 0)
+        int d = texto[i] - '0';
+        if (v > (INT_MAX - d) / 10) return false;
+        v = v * 10 + d;
+    }
+    *valor = v;
+    return true;
+}
+
+/* Potências de 10 representadas exatamente em um double (até 10^22) */
+static const double potencias_dez[] = 
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#ifdef __SIZEOF_INT128__
+/* 
+    Eisel-Lemire: arredonda w * 10^q para o double mais próximo (empates para o par) usando
+    o produto de w pela potência de 5 com 128 bits. false se q está fora da tabela.
+*/
+static bool eisel_lemire(uint64_t w, int q, double *valor)
+{
+    if (q < POT5_MIN || q > POT5_MAX) return false;
+
+    const uint64_t *pot = potencias_cinco[q - POT5_MIN];
+    int zeros = __builtin_clzll(w);
+    w <<= zeros;
+
+    // Só a parte alta da potência costuma bastar; a parte baixa entra quando os bits que decidem o arredondamento estão todos ligados
+    unsigned __int128 produto = (unsigned __int128)w * pot[0];
+    uint64_t alto = (uint64_t)(produto >> 64);
+    uint64_t baixo = (uint64_t)produto;
+    const uint64_t mascara = 0xFFFFFFFFFFFFFFFFull >> 55;
+    if ((alto & mascara) == mascara)
     {
-        return PR_REALCON;
+        uint64_t alto2 = (uint64_t)(((unsigned __int128)w * pot[1]) >> 64);
+        baixo += alto2;
+        if (alto2 > baixo) alto++;
     }
-    if (strcmp(lexema, "char") == 0)
+
+    int bit_alto = (int)(alto >> 63);
+    int desloc = bit_alto + 9;
+    uint64_t mantissa = alto >> desloc;
+    int expoente2 = (((152170 + 65536) * q) >> 16) + 63 + bit_alto - zeros + 1023;
+    if (expoente2 <= 0 || expoente2 >= 0x7FF) return false; // Subnormais e infinito não ocorrem nas constantes do CShort
+
+    // Empate exato (só possível para -4 <= q <= 23): arredonda para o par
+    if (baixo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << desloc) == alto)
     {
-        return PR_CHARCON;
-    } 
-    if (strcmp(lexema, "string") == 0)
+        mantissa &= ~1ull;
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ull << 52))
     {
-        return PR_STRINGCON;
+        mantissa = 1ull << 52;
+        expoente2++;
     }
-    if (strcmp(lexema, "break") == 0) 
+    mantissa &= ~(1ull << 52);
+
+    uint64_t bits = mantissa | ((uint64_t)expoente2 << 52);
+    memcpy(valor, &bits, sizeof(bits));
+    return true;
+}
+#endif
+
+/* 
+    Converte uma constante real ('ponto' aponta para o '.' dentro de 'texto').
+    Os primeiros 19 dígitos significativos vão para w (valor = w * 10^q). Quando w e 10^|q| são
+    exatos em double, uma multiplicação ou divisão já dá o resultado correto; senão vale o
+    Eisel-Lemire. Com dígitos descartados, o resultado só é aceito se w e w + 1 arredondarem
+    para o mesmo double; nos raros casos restantes, a conversão fica com strtod.
+*/
+static double converte_real(const char *texto, int n, const char *ponto)
+{
+    uint64_t w = 0;
+    int significativos = 0;
+    int q = 0;
+    bool truncado = false;
+
+    for (const char *c = texto; c < texto + n; c++)
     {
-        return PR_BREAK;
+        if (c == ponto) continue;
+        int d = *c - '0';
+        if (significativos < 19)
+        {
+            if (w != 0 || d != 0)
+            {
+                w = w * 10 + d;
+                significativos++;
+            }
+        }
+        else
+        {
+            truncado |= d != 0;
+            q++;
+        }
+        if (c > ponto) q--;
     }
-    if (strcmp(lexema, "continue") == 0)
+
+    if (w == 0) return 0.0;
+    if (!truncado && w <= (1ull << 53) && q >= -22 && q <= 22)
     {
-        return PR_CONTINUE;
+        return q < 0 ? (double)w / potencias_dez[-q] : (double)w * potencias_dez[q];
     }
-    if (strcmp(lexema, "void") == 0)
+
+#ifdef __SIZEOF_INT128__
+    double valor, valor_acima;
+    if (eisel_lemire(w, q, &valor))
     {
-        return PR_VOID;
+        if (!truncado) return valor;
+        if (eisel_lemire(w + 1, q, &valor_acima) && valor == valor_acima) return valor;
     }
-    if (strcmp(lexema, "bool") == 0)
+#endif
+
+    char num_completo[TAM_NUM * 2 + 2];
+    memcpy(num_completo, texto, n);
+    num_completo[n] = '\0';
+    return strtod(num_completo, NULL);
+}
+
+/* 
+    Erros de monta_token: na leitura especulativa de um trecho (falhou != NULL) o erro só é anotado,
+    porque o trecho pode ter começado no meio de um comentário; fora dela, o erro é fatal.
+*/
+#define FALHA(msg) do { if (falhou != NULL) { *falhou = true; return t; } error(msg); } while (0)
+
+/* 
+    Monta o token correspondente ao estado final em que o AFD parou.
+    'texto' são os 'n' caracteres consumidos desde a última saída de q0: aponta para o buffer
+    da fonte, ou para um buffer local (com no máximo TAM_TEXTO_ARQUIVO caracteres guardados)
+    na leitura via FILE*. Em ID e CT_STRING, 'inicio'/'tamanho' ficam com o recorte de 'texto'
+    (o corpo, no caso da string); o texto só é internado depois, por interna_token.
+*/
+static TOKEN monta_token(int estado, const char *texto, int n, bool *falhou)
+{
+    TOKEN t;
+    t.nome = SEM_NOME;
+    t.inicio = NULL;
+    t.tamanho = 0;
+
+    switch (estado)
     {
-        return PR_BOOL;
+        // Identificador ou palavra reservada
+        case AFD_Q3:
+        {
+            if (n > TAM_MAX_LEXEMA - 1) FALHA("Identificador excede o tamanho maximo.");
+
+            // O hash usa só o tamanho e as letras das pontas, que o AFD acabou de ler: sem cópia nem segunda passada
+            int pr_codigo = check_reserved_span(texto, n);
+
+            if (pr_codigo != 0)
+            {
+                t.cat = PALAVRA_RESERVADA;
+                t.codigo = pr_codigo;
+            }
+            else
+            {
+                t.cat = ID;
+                t.inicio = texto;
+                t.tamanho = n;
+            }
+            return t;
+        }
+        // Constante inteira
+        case AFD_Q12:
+        {
+            if (n > TAM_NUM - 1) FALHA("Constante inteira muito longa.");
+            if (!converte_inteiro(texto, n, &t.valInt)) FALHA("Constante inteira excede o maior valor de int.");
+            t.cat = CT_INT;
+            return t;
+        }
+        // Constante real: parte inteira + '.' + parte decimal
+        case AFD_Q14:
+        {
+            int guardados = n < TAM_TEXTO_ARQUIVO ? n : TAM_TEXTO_ARQUIVO;
+            const char *ponto = memchr(texto, '.', guardados);
+            if (ponto == NULL || ponto - texto > TAM_NUM - 1) FALHA("Constante inteira muito longa.");
+            if (n - (ponto - texto) - 1 > TAM_NUM - 1) FALHA("Parte decimal da constante real excede o tamanho maximo.");
+
+            t.cat = CT_REAL;
+            t.valReal = converte_real(texto, n, ponto);
+            return t;
+        }
+        // Charcon: 'c', '\n' e '\0'
+        case AFD_Q5:
+        case AFD_Q9:
+        case AFD_Q10:
+            t.cat = estado == AFD_Q9 ? CT_BN : (estado == AFD_Q10 ? CT_BZ : CT_CHAR);
+            t.valInt = 0;
+            t.lexema[0] = estado == AFD_Q9 ? '\n' : (estado == AFD_Q10 ? '\0' : texto[1]);
+            return t;
+        // Stringcon: cada escape (\n e \") ocupa dois caracteres no corpo e vira um só no texto
+        case AFD_Q16:
+        {
+            const char *corpo = texto + 1;
+            int tam_corpo = n - 2;
+            int escapes = 0;
+            if (tam_corpo > 2 * (TAM_MAX_LEXEMA - 1)) FALHA("Constante de string excede o tamanho maximo.");
+            for (int i = 0; i < tam_corpo; i++) escapes += (corpo[i] == '\\');
+            if (tam_corpo - escapes > TAM_MAX_LEXEMA - 1) FALHA("Constante de string excede o tamanho maximo.");
+
+            t.cat = CT_STRING;
+            t.inicio = corpo;
+            t.tamanho = tam_corpo;
+            return t;
+        }
+        // Fim do arquivo
+        case AFD_Q28:
+            t.cat = FIM_ARQ;
+            return t;
     }
-    if (strcmp(lexema, "float") == 0)
+
+    // Sinais e operadores
+    t.cat = SN;
+    switch (estado)
     {
-        return PR_FLOAT;
+        case AFD_Q17: t.codigo = FECHA_PARENTESES; break;
+        case AFD_Q18: t.codigo = ABRE_PARENTESES; break;
+        case AFD_Q19: t.codigo = ABRE_CHAVES; break;
+        case AFD_Q20: t.codigo = FECHA_CHAVES; break;
+        case AFD_Q21: t.codigo = ABRE_COLCHETES; break;
+        case AFD_Q22: t.codigo = FECHA_COLCHETES; break;
+        case AFD_Q23: t.codigo = SN_SOMA; break;
+        case AFD_Q24: t.codigo = SN_SUBTRACAO; break;
+        case AFD_Q25: t.codigo = SN_MULTIPLICACAO; break;
+        case AFD_Q26: t.codigo = PONTO_VIRGULA; break;
+        case AFD_Q27: t.codigo = VIRGULA; break;
+        case AFD_Q30: t.codigo = SN_MAIOR; break;
+        case AFD_Q31: t.codigo = SN_MENOR_IGUAL; break;
+        case AFD_Q32: t.codigo = SN_MAIOR_IGUAL; break;
+        case AFD_Q33: t.codigo = SN_MENOR; break;
+        case AFD_Q36: t.codigo = SN_COMPARACAO; break;
+        case AFD_Q37: t.codigo = SN_ATRIBUICAO; break;
+        case AFD_Q39: t.codigo = SN_AND; break;
+        case AFD_Q41: t.codigo = SN_OR; break;
+        case AFD_Q43: t.codigo = SN_DIVISAO; break;
+        case AFD_Q47: t.codigo = SN_DIFERENTE; break;
+        case AFD_Q48: t.codigo = SN_NEGACAO; break;
+        default:
+        {
+            // Um estado final novo no diagrama precisa de uma ação aqui
+            char msg_err[100];
+            sprintf(msg_err, "Estado final q%d do AFD sem token associado.", estado);
+            FALHA(msg_err);
+        }
     }
-    if (strcmp(lexema, "double") == 0)
+    return t;
+}
+
+/* 
+    Troca o recorte de um token ID ou CT_STRING deixado por monta_token pelo texto internado
+    na tabela de nomes, decodificando os escapes da string. Os demais tokens não mudam.
+*/
+static void interna_token(TOKEN *t)
+{
+    if (t->cat != ID && t->cat != CT_STRING) return;
+
+    if (t->cat == CT_STRING && memchr(t->inicio, '\\', t->tamanho) != NULL)
     {
-        return PR_DOUBLE;
+        char decodificado[TAM_MAX_LEXEMA];
+        int tamanho_lexema = 0;
+        for (int i = 0; i < t->tamanho; i++)
+        {
+            if (t->inicio[i] == '\\')
+            {
+                i++;
+                decodificado[tamanho_lexema++] = t->inicio[i] == 'n' ? '\n' : '"';
+            }
+            else
+            {
+                decodificado[tamanho_lexema++] = t->inicio[i];
+            }
+        }
+        t->nome = interna_nome(decodificado, tamanho_lexema);
     }
-    if (strcmp(lexema, "do") == 0)
+    else
     {
-        return PR_DO;
+        t->nome = interna_nome(t->inicio, t->tamanho);
     }
+    t->inicio = texto_nome(t->nome);
+    t->tamanho = tamanho_nome(t->nome);
+}
 
-    return 0; // Não é palavra reservada
+/* 
+    Núcleo do Analex sobre a fonte em memória: lê um token a partir de '*cursor' (que avança até
+    logo depois dele) e soma em '*linha' as quebras de linha consumidas. O token volta sem nome internado.
+    Com 'falhou' NULL, um erro léxico é fatal; senão, a leitura só marca *falhou, para que um trecho
+    lido de forma especulativa por pre_analex_paralelo possa ser descartado.
+
+    Loop principal: uma consulta à tabela por caractere, até chegar a um estado final.
+    Brancos e comentários levam o AFD de volta a q0, o que recomeça o lexema.
+    A tabela já diz se o caractere é consumido ou devolvido (transições por OUTRO*).
+*/
+static TOKEN analex_buffer(const char **cursor, const char *fim, int *linha, bool *falhou)
+{
+    int estado = AFD_ESTADO_INICIAL; //Estado atual do AFD (as constantes AFD_Qn seguem os nomes do diagrama)
+    unsigned char prox;              //Entrada da tabela: próximo estado + bit de retrocesso
+
+    const char *p = *cursor;
+    if (pulos_ativos) p = pula_brancos(p, fim, linha);
+    const char *inicio = p;
+
+    while (true)
+    {
+        int classe = p < fim ? afd_classe[(unsigned char)*p] : AFD_CLASSE_EOF;
+        prox = afd_transicao[estado][classe];
+        if (prox == AFD_ERRO)
+        {
+            *cursor = p;
+            if (falhou != NULL)
+            {
+                TOKEN t;
+                *falhou = true;
+                t.cat = FIM_ARQ;
+                return t;
+            }
+            erro_lexico(estado, p < fim ? (unsigned char)*p : EOF);
+        }
+        if (!(prox & AFD_RETROCEDE))
+        {
+            *linha += (*p == '\n');
+            p++;
+        }
+        estado = prox & ~AFD_RETROCEDE;
+        if (afd_final[estado]) break;
+
+        // Nos estados com repetições longas, salta direto para o primeiro caractere que sai delas
+        if (estado == AFD_ESTADO_INICIAL)
+        {
+            if (pulos_ativos) p = pula_brancos(p, fim, linha);
+            inicio = p;
+        }
+        else if (pulos_ativos && (estado == AFD_Q44 || estado == AFD_Q15))
+        {
+            p = estado == AFD_Q44 ? pula_comentario(p, fim, linha) : pula_string(p, fim);
+        }
+    }
+
+    *cursor = p;
+    return monta_token(estado, inicio, (int)(p - inicio), falhou);
 }
 
 TOKEN Analex(FILE *fd) 
 {
-    int estado = 0; //Variável para controlar os estados do AFD
-    char lexema[TAM_MAX_LEXEMA] = ""; //Array para guardar o lexema
-    /* LEXEMA (Para nunca mais esquecer) 
-        Definição: palavra ou símbolo específico encontrado no código-fonte
-        que corresponde a uma categoria léxica(token), como palavra-chave,
-        identificador, dígito, sinais, operador,etc.
+    TOKEN t;
 
-        Token --> dígito
-        Lexema --> 555555
+    if (fonte.ativa)
+    {
+        if (!pulos_conferidos) confere_pulos();
+        t = analex_buffer(&fonte.cursor, fonte.fim, &contLinha, NULL);
+        interna_token(&t);
+        return t;
+    }
 
-        Token --> Categoria abstrata
-        Lexema --> Representação concreta de um determinado token
-    */
-    int tamanho_lexema = 0; //Contador para armazenar o tamanho do lexema
-    char digitos_int[TAM_NUM] = ""; //Array para armazenar os dígitos inteiros
-    int tamanho_digito = 0; //Contador para armazenar o tamanho do dígito
-    char digitos_real[TAM_NUM] = ""; //Array para armazenar os dígitos reais
-    int tamanho_digito_real = 0; //Contador para armazenar o tamanho do digito real
-    TOKEN t; //Variável token que será atualizada para cada token lido.
+    // Sem a fonte em memória: mesmo AFD, lendo com fgetc e guardando o lexema em um buffer local
+    int estado = AFD_ESTADO_INICIAL;
+    unsigned char prox;
+    char texto[TAM_TEXTO_ARQUIVO];
+    int n = 0;
     int c; // 'c' DEVE SER INT para fgetc() retornar EOF corretamente
 
-    /* 
-        Loop principal. 
-        Continua até encontrar um token ou um erro (neste caso, encerra o programa)
-    */
-    while (true) 
+    while (true)
     {
-        switch (estado) 
+        c = fgetc(fd);
+        prox = afd_transicao[estado][c == EOF ? AFD_CLASSE_EOF : afd_classe[c]];
+        if (prox == AFD_ERRO) erro_lexico(estado, c);
+        if (prox & AFD_RETROCEDE)
         {
-            case 0: // Estado Inicial (Q0)
-
-                /*  
-                    Tratando espaços em branco e quebras de linha
-                    Fica em um loop infinito até encontrar um caractere não branco ou um EOF
-                */
-                while (true) 
-                { 
-                    c = fgetc(fd);
-                    //Se for vazio ou tab
-                    if (c == ' ' || c == '\t' || c == '\r') 
-                    {
-                        continue; 
-                    } 
-                    else if (c == '\n') 
-                    {
-                        contLinha++;
-                        continue; 
-                    } 
-                    else 
-                    {
-                        break; // Caractere não branco ou EOF encontrado, sai deste loop interno
-                    }
-                }
-
-                // Se após consumir brancos, chegamos ao EOF, retorna o token FIM_ARQ.
-                if (c == EOF) //Q28 no AFD
-                {
-                    t.cat = FIM_ARQ;
-                    return t;
-                }
-
-                // Reseta os buffers e contadores para o novo token
-                tamanho_lexema = 0;
-                tamanho_digito = 0;
-                tamanho_digito_real = 0;
-
-                // Aqui 'c' é o primeiro caractere *significativo* de um potencial token.
-                // Estado de Identificador ou Palavra Reservada (primeiro caractere é letra)
-                if (is_letter(c)) 
-                { 
-                    estado = 1; //Vai para o estado de reconhecimento de Identificador/Palavra Reservada
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1) 
-                    {
-                        lexema[tamanho_lexema] = (char)c;
-                        tamanho_lexema++;
-                    }
-                    else error("Identificador muito longo.");
-                }
-                // Início de Constante Inteira(primeiro caractere é dígito)
-                else if (is_digit(c)) 
-                { 
-                    estado = 2; // Vai para o estado de reconhecimento de CT_INT 
-                    if(tamanho_digito < TAM_NUM - 1) 
-                    {
-                        digitos_int[tamanho_digito] = (char)c;
-                        tamanho_digito++;
-                    }
-                    else
-                    {
-                        error("Constante inteira muito longa.");
-                    } 
-                } 
-                /* SINAIS/OPERADORES */
-                /* Sinais que não precisam setar o estado, posso retornar logo aqui */
-                //ADIÇÃO - Q23
-                else if (c == '+') 
-                {
-                    t.cat = SN; 
-                    t.codigo = SN_SOMA; 
-                    return t;
-                }
-                //SUBTRAÇÃO - Q24
-                else if (c == '-') 
-                {
-                    t.cat = SN; 
-                    t.codigo = SN_SUBTRACAO;
-                    return t;
-                }
-                //MULTIPLICAÇÃO - Q25
-                else if (c == '*') 
-                {
-                    t.cat = SN; 
-                    t.codigo = SN_MULTIPLICACAO; 
-                    return t;
-                }
-                //ABRE PARÊNTESES  - Q18
-                else if (c == '(') 
-                {
-                    t.cat = SN; 
-                    t.codigo = ABRE_PARENTESES;
-                    return t;
-                }
-                //FECHA PARÊNTESES - Q17 
-                else if (c == ')') 
-                {
-                    t.cat = SN;
-                    t.codigo = FECHA_PARENTESES; 
-                    return t;
-                }
-                //ABRE CHAVES - Q19
-                else if (c == '{') 
-                {
-                    t.cat = SN; 
-                    t.codigo = ABRE_CHAVES; 
-                    return t;
-                }
-                //FECHA CHAVES - Q20 
-                else if (c == '}') 
-                {
-                    t.cat = SN; 
-                    t.codigo = FECHA_CHAVES; 
-                    return t;
-                }
-                //ABRE COLCHETE - Q21 
-                else if (c == '[') 
-                {
-                    t.cat = SN; 
-                    t.codigo = ABRE_COLCHETES; 
-                    return t;
-                }
-                //FECHA COLCHETE - Q22 
-                else if (c == ']') 
-                {
-                    t.cat = SN; 
-                    t.codigo = FECHA_COLCHETES; 
-                    return t;
-                }
-                //PONTO E VÍRGULA - Q26
-                else if (c == ';') 
-                { 
-                    t.cat = SN;
-                    t.codigo = PONTO_VIRGULA; 
-                    return t;
-                }
-                //VÍRGULA - Q27
-                else if (c == ',') 
-                {
-                    t.cat = SN; 
-                    t.codigo = VIRGULA; 
-                    return t;
-                }
-                //ATRIBUIÇÃO E POSSÍVEL COMPARAÇÃO - Q35 - Q37
-                else if (c == '=') 
-                {
-                    estado = 8;
-                }
-                //NEGAÇÃO E POSSÍVEL DIFERENTE  - Q46 - Q48
-                else if (c == '!') 
-                {
-                    estado = 9;
-                } 
-                //MENOR QUE E POSSÍVEL MENOR IGUAL - Q34 - Q33
-                else if (c == '<') 
-                {
-                    estado = 10;
-                } 
-                //MAIOR QUE E POSSÍVEL MAIOR IGUAL - Q29 - Q32
-                else if (c == '>') 
-                {
-                    estado = 11;
-                } 
-                // INÍCIO CHARCON - Q2 -Q5
-                // Para não esquecer ... \' em C é a forma de você simbolizar as aspas simples ou apóstrofo
-                else if (c == '\'') 
-                {
-                    estado = 12;                 
-                }
-                // INÍCIO STRINGCON - Q15-Q16
-                else if (c == '"') 
-                {
-                    estado = 13; 
-                }
-                //Estado de divisão ou possível comentário
-                //No AFD são Q42 - Q45
-                else if (c == '/') 
-                {
-                    estado = 15; 
-                } 
-                //Estado inicial para && (operador AND)
-                // No AFD são Q38 - Q39
-                else if (c == '&') 
-                { 
-                    // Início potencial de &&
-                    estado = 21;
-                } 
-                //Estado inicial para || (operador OR)
-                // No AFD são Q40 - Q41
-                else if (c == '|') 
-                { 
-                    estado = 22; //Vai para o estado do potencial OR
-                }  
-                //Se o caracter não for válido, aponto erro.
-                else 
-                {
-                    // Se o caractere não se encaixar em NENHUMA regra léxica neste ponto, é um erro.
-                    char msg_err[100]; 
-                    sprintf(msg_err, "Caracter '%c' invalido.", c);
-                    error(msg_err);
-                }
-                break;
-            
-
-            /************************************** TRATAMENTO DE ESTADOS *******************************************************/ 
-            
-            // Estado de Identificador ou Palavra Reservada (após a primeira letra)
-            // No AFD é o Q1 - Q3
-            case 1: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se o próximo caractere 'c' for letra, digito ou '_'
-                if (is_letter(c) || is_digit(c) || c == '_') 
-                {   
-                    //Se o lemexa for menor que o tamanho destinado para o nosso buffer (retirando o -1 do caractere final)
-                    //adicionamos o 'c' lido ao lexema e incrementamos o contador de tamanho.
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1)
-                    {
-                        lexema[tamanho_lexema] = (char)c;
-                        tamanho_lexema++;
-                    }
-                    else
-                    {   
-                        //Caso tenha excedido o tamanho do buffer estipulado
-                        error("Identificador excede o tamanho maximo.");
-                    }
-                    //Permanece no estado 1.
-                    //Não há troca de estado, pois aguardaremos mais letras, dígitos ou '_' para o Identificador ou Palavra Reservada.                      
-                } 
-                else 
-                { 
-                    // Fim do ID/Palavra Reservada
-                    //Se o cactere 'c' não for letra, dígito ou '_', precisamos ir para outro estado.
-                    ungetc(c, fd); // Devolvo 'c' para ser lido na próxima iteração
-                    lexema[tamanho_lexema] = '\0'; // Termina o lexema incluindo o '\0' ao final.
-
-                    //Verifico se é palavra reservada
-                    int pr_codigo = check_reserved_word(lexema);
-                    //Se for palavra reservada
-                    if (pr_codigo != 0)
-                    {
-                        t.cat = PALAVRA_RESERVADA;
-                        t.codigo = pr_codigo;
-                    } 
-                    //Se for Identificador
-                    else 
-                    {   
-                        t.cat = ID;
-                        strcpy(t.lexema, lexema);
-                    }
-
-                    //Retorno o token analisado
-                    return t;
-                }
-                break;
-            // Estado de Constante Inteira (após o primeiro dígito)
-            // No AFD é o Q11 - Q12
-            case 2: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se o próximo caractere for dígito
-                if (is_digit(c)) 
-                {
-                    //Se não estourar o buffer
-                    if (tamanho_digito < TAM_NUM - 1)   
-                    {
-                        digitos_int[tamanho_digito] = (char)c;
-                        tamanho_digito++;
-
-                    }
-                    else 
-                    {
-                        error("Constante inteira muito longa.");
-                    }
-                    
-                    // Permanece no estado 2 
-                    // Não há troca de estados, pois iremos ler todos os dígitos
-                }
-                //Se o caractere for um '.' é o começo de uma constante real, vamos ter que trocar de estado
-                else if (c == '.') 
-                { 
-                    estado = 3; //Vai para o estado de CT_REAL
-                    digitos_int[tamanho_digito] = '\0'; // Finaliza a parte inteira
-                } 
-                else 
-                { 
-                    // Fim da Constante Inteira
-                    ungetc(c, fd); //Devolvo o dígito que não faz mais parte da CT_INT para que ele possa ser lido na próxima iteração
-                    digitos_int[tamanho_digito] = '\0'; //Finalizo os digitos
-
-                    t.cat = CT_INT; 
-                    t.valInt = atoi(digitos_int); //Converto o valor para valor inteiro
-                    return t; //retorno o token
-                }
-                break;
-            // Estado de Constante Real - após o ponto '.'
-            // No AFD é o Q13 
-            case 3: 
-                c = fgetc(fd); // Lê o próximo caractere
-                // Se EOF após '.', é um erro
-                if (c == EOF) 
-                { 
-                    error("Constante real mal formada: EOF apos o ponto.");
-                }
-                //Se for dígito 
-                else if (is_digit(c)) 
-                {
-                    estado = 4; // Vai para o estado de Constante Real - dígitos após o ponto
-                    if (tamanho_digito_real < TAM_NUM - 1) 
-                    {
-                        digitos_real[tamanho_digito_real] = (char)c;
-                        tamanho_digito_real++;
-                    }
-                    else 
-                    {
-                        error("Parte decimal da constante real excede o tamanho maximo.");
-                    }
-                } 
-                //Se o caractere depois do ponto não for dígito
-                else 
-                { 
-                    error("Constante real mal formada: esperado digito apos o ponto.");
-                }
-                break;
-            // Estado de Constante Real - dígitos após o ponto
-            // No AFD é o Q14
-            case 4: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se 'c' for dígito
-                if (is_digit(c)) 
-                {
-                    if (tamanho_digito_real < TAM_NUM - 1)
-                    {
-                        digitos_real[tamanho_digito_real++] = (char)c;
-                    }
-                    else
-                    {
-                        error("Parte decimal da constante real excede o tamanho maximo.");
-                    }
-                    // Permanece no estado 4 até que todos os dígitos sejam lidos (ou seja, até que um caractere diferente
-                    //de dígito seja lido)
-                } 
-                else 
-                {   
-                    // Fim da Constante Real
-                    ungetc(c, fd); //Devolve o caractere não dígito para ser lido na próxima iteração
-                    digitos_real[tamanho_digito_real] = '\0'; //Finaliza o lexema dos dígitos reais
-
-                    char num_completo[TAM_NUM * 2 + 2]; //Aumentando tamanho do número real completo, apenas por via das dúvidas (simular um float)
-                    // Tamanho suficiente para int.real e '.' e '\0'
-                    sprintf(num_completo, "%s.%s", digitos_int, digitos_real); //Concatenando todo o digito real: dígito para inteira + '.' + dígitos parte decimal
-                    
-                    t.cat = CT_REAL;
-                    t.valReal = atof(num_completo); //Convertendo para float
-
-                    return t; //retorno o token
-                }
-                break;
-            // Estado de atribuição ou comparação (Após '=')
-            // No AFD é o Q35 - Q37
-            case 8:
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se vier outra igualdade, é classificado como comparação e retorno o token de comparação
-                if (c == '=') 
-                { 
-                    t.cat = SN;
-                    t.codigo = SN_COMPARACAO; 
-                    return t; 
-                }
-                //Atribuição
-                else 
-                { 
-                    ungetc(c, fd); //Se o próximo caractere não for '=', então é uma atribuição. Devolvo o próximo caractere para próxima iteração.
-                    t.cat = SN;
-                    t.codigo = SN_ATRIBUICAO;
-                    return t; 
-                } 
-                break;
-            // Estado de negação ou diferença (Após '!')
-            // No AFD é o Q46 - Q48
-            case 9: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se o próximo caractere for EOF, está incompleto, logo aponta erro
-                if (c == EOF) 
-                { 
-                    error("Caracter invalido: '!' deve ser seguido por '=' (EOF atingido)."); 
-                }
-                //Se vier o '=', então é diferença
-                else if (c == '=') 
-                { 
-                    t.cat = SN; 
-                    t.codigo = SN_DIFERENTE; 
-                    return t; 
-                }
-                //Se vier qualquer outro *, é negação.
-                else
-                { 
-                    ungetc(c, fd); //Retorno o próximo caractere
-                    t.cat = SN;
-                    t.codigo = SN_NEGACAO;
-                    return t;
-                }
-                break;
-            // Estado menor que ou menor igual (Após '<')
-            // No AFD é o Q34 - Q33
-            case 10: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se o próximo caractere for '=', então é menor igual (<=)
-                if (c == '=') 
-                { 
-                    t.cat = SN;
-                    t.codigo = SN_MENOR_IGUAL; 
-                    return t; 
-                }
-                //Se for qualquer outro *, é menor que (<)
-                else 
-                { 
-                    ungetc(c, fd); //Devolvo o caractere para a próxima iteração
-                    t.cat = SN; 
-                    t.codigo = SN_MENOR; 
-                    return t; 
-                }
-                break;
-            // Estado maior que ou maior igual (Após '>')
-            // No AFD é o Q29 - Q32
-            case 11: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se o próximo caractere for '=', então é maior ou igual (>=)
-                if (c == '=') 
-                { 
-                    t.cat = SN; 
-                    t.codigo = SN_MAIOR_IGUAL; 
-                    return t; 
-                }
-                //Se for qualquer outro *, é maior que ()>)
-                else 
-                { 
-                    ungetc(c, fd); //Devolvo o caractere para o stream novamente
-                    t.cat = SN; 
-                    t.codigo = SN_MAIOR; 
-                    return t; 
-                }
-                break;
-            // Início Charcon (Após o primeiro apóstrofo ('))
-            // No AFD é Q2 - 15
-            case 12: 
-                c = fgetc(fd); // Lê o caractere do charcon
-                //Se o próximo caractere for um EOF, quer dizer que há um erro
-                if (c == EOF) 
-                { 
-                    error("Constante de caractere nao fechada (EOF atingido)."); 
-                }
-                //Tratanto barra invertida
-                //Se for barra invertida, vamos para outro estado tratar isso lá
-                else if (c == '\\') //Psiu!! Para não esquecer: '\\' em c simboliza uma única barra invertida.
-                { 
-                    estado = 16; //Vai para o estado de tratamento de escape
-                }
-                /* 
-                    SEGUNDO A ESPECIFICAÇÃO DA LINGUAGEM:
-                    -charcon (constante de caractere): É definido como 'ch', onde ch denota qualquer caractere imprimível da tabela ASCII, 
-                    diferente de \ (barra invertida) e ' (apóstrofo).
-                    Ou seja, não permite aspas simples vazias (Mas permite strings vazias, como descrito também na especificação)
-
-                    -stringcon (constante de string): É definido como "{ch}" onde ch denota qualquer caractere imprimível da tabela ASCII, diferente 
-                    de " (aspas) e do caractere newline.
-                    As chaves {a} na notação BNF estendida significam "repetição zero ou mais vezes". Portanto, {ch} significa que pode haver zero ou 
-                    mais caracteres ch dentro das aspas duplas.
-                    Isso implica que "" (string vazia) é permitido, pois é a ocorrência de zero caracteres ch.
-                */
-                else if (c == '\'') 
-                { 
-                    error("Aspas simples vazias não são permitidas.");
-                } 
-                //else if (c == '\n') 
-                //{ 
-                //   error("Constante de caractere contem quebra de linha nao escapada.");
-                //   contLinha++; //incremento, pois o \n foi lido
-                //}
-                //Se for um caractere imprimível da tabela ascii
-                else if (is_printable_ascii(c)) 
-                { 
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1)
-                    {
-                        lexema[tamanho_lexema] = (char)c;
-                        tamanho_lexema++;
-                    } 
-                    else 
-                    {
-                        error("Constante de caractere excede o tamanho maximo.");
-                    }
-                    estado = 17; // Estado de verificação de fechamento de apóstrofo
-                } 
-                else 
-                {
-                    char msg_err[100]; 
-                    sprintf(msg_err, "Caracter '%c' invalido em constante de caractere.", c);
-                    error(msg_err);
-                }
-                break;
-            // Início estado de Stringcon (após primeiras aspas duplas '"')
-            // No AFD são os estados Q15 - Q16
-            case 13: 
-                c = fgetc(fd); // Lê o caractere da string
-                //Se for EOF, aponta erro
-                if (c == EOF) 
-                { 
-                    error("Constante de string nao fechada (EOF atingido).");
-                }
-                //Se o próximo caractere for outra aspas, a stringcon acabou aqui
-                /* 
-                    -stringcon (constante de string): É definido como "{ch}" onde ch denota qualquer caractere imprimível da tabela ASCII, diferente 
-                    de " (aspas) e do caractere newline.
-                    As chaves {a} na notação BNF estendida significam "repetição zero ou mais vezes". Portanto, {ch} significa que pode haver zero ou 
-                    mais caracteres ch dentro das aspas duplas.
-                    Isso implica que "" (string vazia) é permitido, pois é a ocorrência de zero caracteres ch.
-                 */
-                else if (c == '"') 
-                { 
-                    // Fim da string
-                    lexema[tamanho_lexema] = '\0'; //Finalizo o lexema
-                    t.cat = CT_STRING;
-                    strcpy(t.lexema, lexema);
-                    return t;
-                } 
-                /* STRING E CHAR ME FODERAMMMMMMMMMMMMMMMMMMMM que porra 
-                Depois vamos ver se realmente é necessário isso ai
-                */
-                /* 
-                Conforme especificação... 
-                stringcon ::=  "{ch}",  onde ch denota qualquer caractere imprimível da tabela ASCII, 
-                como especificado pela função isprint() do C, diferente de  " (aspas) e do 
-                caractere newline.
-               
-                Ou seja, " e \n devem ser tratadas de forma diferente
-                */
-                //Se houver uma barra invertida, vamos ter que tratar escapes para \n e para \" 
-                else if (c == '\\') 
-                { 
-                    // Caractere de escape
-                    estado = 18; //Estado para tratativa de caractere de escape
-                } else if (c == '\n') { // Quebra de linha não escapada em Stringcon
-                    error("Constante de string contem quebra de linha nao escapada.");
-                }
-                else if (is_printable_ascii(c) || c == '\r') { // Caractere normal ou retorno de carro
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1) lexema[tamanho_lexema++] = (char)c;
-                    else error("Constante de string excede o tamanho maximo.");
-                } else {
-                    char msg_err[100]; // Tamanho aumentado
-                    sprintf(msg_err, "Caracter '%c' invalido em constante de string.", c);
-                    error(msg_err);
-                }
-                break;
-            //Início de uma divisão ou possível comentário (Após "/")
-            //No AFD são os estados Q42-Q45
-            case 15: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se for um asterístico, quer dizer que é início de comentário
-                if (c == '*') 
-                { 
-                    estado = 19; //Vamos para o estado que trata o comentário
-                } 
-                //Se for qualquer outro * é divisão
-                else 
-                { 
-                    ungetc(c, fd); //Devolvo o caractere para a próxima iteração 
-                    t.cat = SN; 
-                    t.codigo = SN_DIVISAO; 
-                    return t; 
-                }
-                break;
-            // Estado após barra invertida ('\') do charcon - tratativa de escapes 
-            // No AFD são os estados Q6 - Q10
-            case 16: 
-                c = fgetc(fd); // Lê o caractere escapado
-                //Se o próximo caractere for um EOF, aponto um erro
-                if (c == EOF) 
-                { 
-                    error("Constante de caractere nao fechada: EOF apos escape. \\0 ou \\n"); 
-                } 
-                //Se o próximo caractere for um n, vai ser \n
-                else if (c == 'n') 
-                { 
-                    //Se não estourar o buffer
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1) 
-                    {
-                        lexema[tamanho_lexema] = '\n'; //Adicione o \n no lexema
-                        tamanho_lexema++; //Incrementa o contador
-                        estado = 17; //Vai pro estado de verificação: se há um apóstrofo no final
-                    }
-
-                }
-                //Se o próximo caractere for um 0, vai ser \0
-                else if (c == '0') 
-                { 
-                    //Se não estourar o buffer
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1)
-                    {
-                        lexema[tamanho_lexema] = '\0'; //Adicione o \0 no lexema
-                        tamanho_lexema++; //Incrementa o contadr
-                        estado = 17; //Vai pro estado de verificaçaõ: se há um apóstrofo no final
-                    }
-                }
-                //Se for qualquer outro *, eu aponto um erro. Pois só existem dois escapes \n e \0
-                else 
-                {
-                    char msg_err[100]; 
-                    sprintf(msg_err, "Sequencia de escape '\\%c' invalida.", c);
-                    error(msg_err);
-                }
-                break;
-            // Estado de fechamento de apóstrofo: foca em verificar se o charcon está fechado corretamente
-            //Após o caractere ou escape, esperando a última aspa simples/apóstrofo
-            case 17: 
-                c = fgetc(fd); // Lê o caractere de fechamento
-                //Se o próximo caractere for EOF, há um erro.
-                if (c == EOF) 
-                { 
-                    error("Constante de caractere nao fechada (EOF atingido)."); 
-                }
-                //Se houver o apóstrofo de fechamento corretamente
-                else if (c == '\'') 
-                {
-                    lexema[tamanho_lexema] = '\0'; // Finaliza o lexema
-
-                    // Decide a categoria com base no *conteúdo* de lexema
-                    //Se houver apenas um caractere dentro do lexema \0 ou \n
-                    if (tamanho_lexema == 1) 
-                    { 
-                        //Se for \n
-                        if (lexema[0] == '\n')
-                        {
-                            t.cat = CT_BN;
-                        }
-                        //Se for \0 
-                        else if (lexema[0] == '\0') {
-                            t.cat = CT_BZ;
-                        } else {
-                            t.cat = CT_CHAR;
-                        }
-                    } 
-                    //Se houver mais de um caractere dentro do lexema
-                    else 
-                    {
-                        error("Constante de caractere mal formada: mais de um caractere interno.");
-                    }
-                    strcpy(t.lexema, lexema); // Copia o caractere (ou '\n' ou '\0') para o lexema do token
-                    return t;
-                }
-                //Se não houver apóstrofo, aponto um ero
-                else 
-                {
-                    char msg_err[100]; 
-                    sprintf(msg_err, "Constante de caractere mal formada: esperado 'c'.");
-                    error(msg_err);
-                }
-                break;
-            // Estado para tratativas de escapes do Stringcon (Após '\')
-            // Os dois escapes são \n e \"
-            case 18: 
-                c = fgetc(fd); // Lê o próximo caractere 
-                //Se o caractere é EOF, aponta erro
-                if (c == EOF) 
-                { 
-                    error("Constante de string nao fechada: EOF apos escape.");
-                } 
-                //Se vier um n depois
-                else if (c == 'n') 
-                { 
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1)
-                    {
-                        lexema[tamanho_lexema] = '\n';
-                        tamanho_lexema++;
-                        estado = 13; //Volto pro estado de stringcon
-                    }  
-                }
-                //Se vier uma aspas
-                else if (c == '"') 
-                { 
-                    if (tamanho_lexema < TAM_MAX_LEXEMA - 1)
-                    {
-                        lexema[tamanho_lexema] = '\"'; 
-                        tamanho_lexema++;
-                        estado = 13; //Volto pro estado de stringcon
-                    }  
-                }
-                //Se for qualquer outro caractere, aplicamos erros, pois não há nada na especificação que diga se devo aceitar outros escapes
-                else 
-                {
-                    char msg_err[100]; 
-                    sprintf(msg_err, "Sequencia de escape '\\%c' invalida em string.", c);
-                    error(msg_err);
-                }
+            ungetc(c, fd);
+        }
+        else
+        {
+            contLinha += (c == '\n');
+            if (n < TAM_TEXTO_ARQUIVO) texto[n] = (char)c;
+            n++;
+        }
+        estado = prox & ~AFD_RETROCEDE;
+        if (afd_final[estado]) break;
+        if (estado == AFD_ESTADO_INICIAL) n = 0;
+    }
+
+    t = monta_token(estado, texto, n, NULL);
+    interna_token(&t);
+    return t;
+}
+
+/* Garante espaço para mais um token nos arrays do fluxo, dobrando a capacidade quando necessário */
+static bool cresce_fluxo(FLUXO_TOKENS *fluxo)
+{
+    if (fluxo->quantidade < fluxo->capacidade) return true;
+
+    int nova = fluxo->capacidade ? fluxo->capacidade * 2 : 4096;
+    unsigned char *cat = realloc(fluxo->cat, nova * sizeof(*cat));
+    if (cat) fluxo->cat = cat;
+    unsigned char *codigo = realloc(fluxo->codigo, nova * sizeof(*codigo));
+    if (codigo) fluxo->codigo = codigo;
+    int *linha = realloc(fluxo->linha, nova * sizeof(*linha));
+    if (linha) fluxo->linha = linha;
+    int *valor = realloc(fluxo->valor, nova * sizeof(*valor));
+    if (valor) fluxo->valor = valor;
+
+    if (!cat || !codigo || !linha || !valor) return false;
+    fluxo->capacidade = nova;
+    return true;
+}
+
+/* Guarda o valor de uma constante e devolve seu índice (ou -1 se faltar memória) */
+static int guarda_valor(FLUXO_TOKENS *fluxo, VALOR_TOKEN v)
+{
+    if (fluxo->num_valores == fluxo->cap_valores)
+    {
+        int nova = fluxo->cap_valores ? fluxo->cap_valores * 2 : 1024;
+        VALOR_TOKEN *valores = realloc(fluxo->valores, nova * sizeof(*valores));
+        if (valores == NULL) return -1;
+        fluxo->valores = valores;
+        fluxo->cap_valores = nova;
+    }
+    fluxo->valores[fluxo->num_valores] = v;
+    return fluxo->num_valores++;
+}
+
+/* Acrescenta um token (já com o nome internado) ao fim do fluxo; false se faltar memória */
+static bool guarda_token(FLUXO_TOKENS *fluxo, const TOKEN *t, int linha)
+{
+    if (!cresce_fluxo(fluxo)) return false;
+
+    int i = fluxo->quantidade++;
+    VALOR_TOKEN v;
+    fluxo->cat[i] = (unsigned char)t->cat;
+    fluxo->codigo[i] = 0;
+    fluxo->linha[i] = linha;
+    fluxo->valor[i] = -1;
+
+    switch (t->cat)
+    {
+        case SN:
+        case PALAVRA_RESERVADA:
+            fluxo->codigo[i] = (unsigned char)t->codigo;
+            break;
+        case ID:
+        case CT_STRING:
+            fluxo->valor[i] = t->nome;
+            break;
+        case CT_INT:
+        case CT_REAL:
+        case CT_CHAR:
+        case CT_BN:
+        case CT_BZ:
+            if (t->cat == CT_REAL) v.valReal = t->valReal;
+            else v.valInt = t->cat == CT_INT ? t->valInt : (unsigned char)t->lexema[0];
+            fluxo->valor[i] = guarda_valor(fluxo, v);
+            return fluxo->valor[i] >= 0;
+        default:
+            break;
+    }
+    return true;
+}
+
+bool pre_analex(FILE *fd, FLUXO_TOKENS *fluxo)
+{
+    memset(fluxo, 0, sizeof(*fluxo));
+
+    if (!fonte.ativa && !carregar_fonte(fd)) return false;
+
+    // Se faltar memória no meio, a leitura volta ao ponto de partida para o Analex sob demanda
+    const char *cursor_inicial = fonte.cursor;
+    int linha_inicial = contLinha;
+    bool ok = true;
+
+    TOKEN t;
+    do
+    {
+        t = Analex(fd);
+        ok = guarda_token(fluxo, &t, contLinha);
+    } while (ok && t.cat != FIM_ARQ);
+
+    if (!ok)
+    {
+        liberar_fluxo(fluxo);
+        fonte.cursor = cursor_inicial;
+        contLinha = linha_inicial;
+        return false;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+/* 
+    Token lido por uma thread de pre_analex_paralelo. As posições são deslocamentos a partir
+    do início da fonte e 'linha' conta as quebras de linha desde o começo do trecho.
+*/
+typedef struct 
+{
+    unsigned char cat;
+    unsigned char codigo;
+    unsigned short tamanho; // Recorte do texto de ID/CT_STRING (corpo da string, ainda com os escapes)
+    unsigned int inicio;
+    unsigned int fim;       // Cursor logo depois do token: o AFD está em q0 nesse ponto
+    int linha;              // Quebras de linha entre o começo do trecho e 'fim'
+    VALOR_TOKEN valor;      // Constantes numéricas e caractere de CT_CHAR/CT_BN/CT_BZ
+} TOKEN_TRECHO;
+
+/* Um trecho da fonte, lido por uma thread a partir de um começo de linha */
+typedef struct 
+{
+    const char *inicio;     // Primeiro caractere do trecho (logo depois de um '\n', exceto no primeiro)
+    const char *limite;     // Começo do trecho seguinte: a leitura para no primeiro token que termina nele ou depois
+    TOKEN_TRECHO *tokens;
+    int quantidade;
+    int capacidade;
+    bool falhou;            // A leitura parou em um erro léxico, logo depois do último token guardado
+    bool sem_memoria;
+} TRECHO;
+
+/* 
+    Lê um trecho supondo que ele começa em q0. Isso só não vale quando o trecho começa dentro de
+    um comentário (strings não passam de uma linha); nesse caso os tokens lidos não batem com os
+    do trecho anterior e são descartados na costura, ou a leitura para em um erro especulativo.
+*/
+static void *le_trecho(void *arg)
+{
+    TRECHO *tr = arg;
+    const char *p = tr->inicio;
+    int linha = 0;
+
+    while (true)
+    {
+        TOKEN t = analex_buffer(&p, fonte.fim, &linha, &tr->falhou);
+        if (tr->falhou) break;
+
+        if (tr->quantidade == tr->capacidade)
+        {
+            int nova = tr->capacidade ? tr->capacidade * 2 : 4096;
+            TOKEN_TRECHO *tokens = realloc(tr->tokens, nova * sizeof(*tokens));
+            if (tokens == NULL)
+            {
+                tr->sem_memoria = true;
                 break;
-            //Estado para tratar comentários
-            //Após asterístico
-            case 19: 
-                // Dentro de comentário /*
-                c = fgetc(fd); // Lê o caractere dentro do comentário
-                //Se for EOF, aponta erro
-                if (c == EOF) 
-                { 
-                    error("Comentario nao fechado (EOF atingido).");
-                }
-                //Se for outro asterístico, vamos pro estados para tratar o fechamento do comentário 
-                else if (c == '*') 
-                { 
-                    estado = 20; //Estado para tratar o fechamento do comentário
-                }
-                //Se for qualquer outra coisa, permanece no mesmo estado, isto é, dentro do comentário
-                //Só devemos consumir qualquer caractere, depois que o comentário for fechado. 
-                //Portanto, devemos ficar atentos apenas para asterístico para irmos para o próximo estado 
-                else 
-                {
-                    if (c == '\n')
-                    {
-                        contLinha++; //Incrementa linha, apenas para termos uma depuração precisa
-                    }
-                    // Permanece no estado 19
-                }
+            }
+            tr->tokens = tokens;
+            tr->capacidade = nova;
+        }
+
+        TOKEN_TRECHO *tt = &tr->tokens[tr->quantidade++];
+        tt->cat = (unsigned char)t.cat;
+        tt->codigo = 0;
+        tt->tamanho = 0;
+        tt->inicio = 0;
+        tt->fim = (unsigned int)(p - fonte.base);
+        tt->linha = linha;
+        switch (t.cat)
+        {
+            case SN:
+            case PALAVRA_RESERVADA:
+                tt->codigo = (unsigned char)t.codigo;
                 break;
-            //Estado para tratar o fechamento do asterístico 
-            //Estamos dentro do comentário e encontramos um asterístico (possívelmente o que antecede o fechamento do comentário)
-            case 20: 
-                c = fgetc(fd); // Lê o caractere de fechamento do comentário
-                //Se for EOF, aponto erro
-                if (c == EOF) 
-                { 
-                    error("Comentario nao fechado (EOF atingido).");
-                }
-                //Se for uma barra, finalizamos o comentário 
-                else if (c == '/') 
-                { 
-                    // Fim de comentário */
-                    estado = 0; // Comentário fechado, volta ao estado inicial para buscar o próximo token
-                    // Não retorna token, o loop no `Analex continua do `case 0`.
-                }
-                //Se for outro caractere, eu volto pro estado 19 para tratativa 
-                else 
-                {    
-                    ungetc(c, fd); // Devolve o caractere para ser reavaliado no estado 19
-                    estado = 19; // Volta para o estado 19 (ainda dentro do comentário)
-                }
+            case ID:
+            case CT_STRING:
+                tt->inicio = (unsigned int)(t.inicio - fonte.base);
+                tt->tamanho = (unsigned short)t.tamanho;
                 break;
-            //Início para operador and (Após '&' (potencial '&&'))
-            case 21: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se for outro &, então encontramos o and
-                if (c == '&') 
-                {
-                    t.cat = SN; 
-                    t.codigo = SN_AND; 
-                    return t;
-                }
-                //Se for qualquer outro caractere, aponta erro 
-                else 
-                {
-                    error("Caracter invalido: '&' deve ser seguido por '&'.");
-                }
+            case CT_INT: tt->valor.valInt = t.valInt; break;
+            case CT_REAL: tt->valor.valReal = t.valReal; break;
+            case CT_CHAR:
+            case CT_BN:
+            case CT_BZ:
+                tt->valor.valInt = (unsigned char)t.lexema[0];
                 break;
-            //Início para operador OR ( Após '|' (potencial '||'))
-            case 22: 
-                c = fgetc(fd); // Lê o próximo caractere
-                //Se for outro |, encontramos nosso OR
-                if (c == '|') 
-                {
-                    t.cat = SN; t.codigo = SN_OR; return t;
-                }
-                //Se for qualquer outro caracter, apontamos erro 
-                else {
-                    error("Caracter invalido: '|' deve ser seguido por '|'.");
-                }
+            default:
                 break;
         }
+
+        if (t.cat == FIM_ARQ || p >= tr->limite) break;
+    }
+    return NULL;
+}
+
+/* Reconstrói o TOKEN de um token de trecho, internando o texto de ID/CT_STRING */
+static TOKEN token_do_trecho(const TOKEN_TRECHO *tt)
+{
+    TOKEN t;
+    t.cat = tt->cat;
+    t.nome = SEM_NOME;
+    t.inicio = NULL;
+    t.tamanho = 0;
+
+    switch (t.cat)
+    {
+        case SN:
+        case PALAVRA_RESERVADA:
+            t.codigo = tt->codigo;
+            break;
+        case ID:
+        case CT_STRING:
+            t.inicio = fonte.base + tt->inicio;
+            t.tamanho = tt->tamanho;
+            interna_token(&t);
+            break;
+        case CT_INT: t.valInt = tt->valor.valInt; break;
+        case CT_REAL: t.valReal = tt->valor.valReal; break;
+        case CT_CHAR:
+        case CT_BN:
+        case CT_BZ:
+            t.valInt = 0;
+            t.lexema[0] = (char)tt->valor.valInt;
+            break;
+        default:
+            break;
+    }
+    return t;
+}
+
+/* 
+    Procura no trecho o token depois do qual o cursor está em 'p' (por busca binária: 'fim' cresce).
+    Devolve o índice do token seguinte, 0 se 'p' é o começo do trecho, ou -1 se o trecho não passou por 'p'.
+*/
+static int sincroniza_trecho(const TRECHO *tr, const char *p)
+{
+    if (p == tr->inicio) return 0;
+
+    unsigned int alvo = (unsigned int)(p - fonte.base);
+    int esq = 0, dir = tr->quantidade - 1;
+    while (esq <= dir)
+    {
+        int meio = (esq + dir) / 2;
+        if (tr->tokens[meio].fim == alvo) return meio + 1;
+        if (tr->tokens[meio].fim < alvo) esq = meio + 1;
+        else dir = meio - 1;
+    }
+    return -1;
+}
+
+bool pre_analex_paralelo(FILE *fd, FLUXO_TOKENS *fluxo, int num_threads)
+{
+    if (!fonte.ativa && !carregar_fonte(fd)) return false;
+
+    // Arquivos pequenos não compensam as threads; deslocamentos de 32 bits limitam o tamanho
+    size_t tam = (size_t)(fonte.fim - fonte.cursor);
+    if (num_threads > MAX_THREADS_ANALEX) num_threads = MAX_THREADS_ANALEX;
+    if (num_threads < 2 || tam < TAM_MIN_PARALELO || (size_t)(fonte.fim - fonte.base) > 0xFFFFFFFFu)
+    {
+        return pre_analex(fd, fluxo);
+    }
+    if (!pulos_conferidos) confere_pulos();
+
+    // Divide a fonte em trechos de tamanhos parecidos, cada um começando logo depois de um '\n'
+    TRECHO trechos[MAX_THREADS_ANALEX];
+    int num_trechos = 0;
+    const char *comeco = fonte.cursor;
+    for (int k = 0; k < num_threads && comeco < fonte.fim; k++)
+    {
+        memset(&trechos[num_trechos], 0, sizeof(TRECHO));
+        trechos[num_trechos++].inicio = comeco;
+
+        const char *alvo = fonte.cursor + tam / num_threads * (k + 1);
+        const char *quebra = k + 1 < num_threads && alvo < fonte.fim ? memchr(alvo, '\n', fonte.fim - alvo) : NULL;
+        comeco = quebra != NULL ? quebra + 1 : fonte.fim;
+    }
+    for (int k = 0; k < num_trechos; k++)
+    {
+        trechos[k].limite = k + 1 < num_trechos ? trechos[k + 1].inicio : fonte.fim;
+    }
+
+    // Cada trecho é lido em sua thread; se uma thread não puder ser criada, o trecho é lido aqui mesmo
+    pthread_t threads[MAX_THREADS_ANALEX];
+    bool criada[MAX_THREADS_ANALEX];
+    for (int k = 0; k < num_trechos; k++)
+    {
+        criada[k] = pthread_create(&threads[k], NULL, le_trecho, &trechos[k]) == 0;
+        if (!criada[k]) le_trecho(&trechos[k]);
+    }
+    bool ok = true;
+    for (int k = 0; k < num_trechos; k++)
+    {
+        if (criada[k]) pthread_join(threads[k], NULL);
+        if (trechos[k].sem_memoria) ok = false;
+    }
+
+    /* 
+        Costura, em ordem: 'p' é a posição (em q0) logo depois do último token do fluxo e 'linha'
+        é o contLinha exato nesse ponto. Se o trecho que contém 'p' também passou por 'p', seus
+        tokens seguintes são exatamente os da leitura serial e entram direto, com as linhas
+        deslocadas pela diferença de quebras. Senão (trecho começou dentro de um comentário ou
+        parou em um erro), o próximo token é lido aqui, de forma serial, e a busca recomeça.
+    */
+    memset(fluxo, 0, sizeof(*fluxo));
+    const char *p = fonte.cursor;
+    int linha = contLinha;
+    int k = 0;
+    bool fim = false;
+
+    while (ok && !fim)
+    {
+        while (k + 1 < num_trechos && p >= trechos[k + 1].inicio) k++;
+
+        const TRECHO *tr = &trechos[k];
+        int i = sincroniza_trecho(tr, p);
+        if (i >= 0 && i < tr->quantidade)
+        {
+            int quebras_antes = i > 0 ? tr->tokens[i - 1].linha : 0;
+            for (; i < tr->quantidade && ok; i++)
+            {
+                TOKEN t = token_do_trecho(&tr->tokens[i]);
+                ok = guarda_token(fluxo, &t, linha + tr->tokens[i].linha - quebras_antes);
+            }
+            const TOKEN_TRECHO *ultimo = &tr->tokens[tr->quantidade - 1];
+            p = fonte.base + ultimo->fim;
+            linha += ultimo->linha - quebras_antes;
+            fim = ultimo->cat == FIM_ARQ;
+        }
+        else
+        {
+            // Um erro léxico de verdade aparece aqui, com a linha certa em contLinha
+            contLinha = linha;
+            TOKEN t = analex_buffer(&p, fonte.fim, &contLinha, NULL);
+            interna_token(&t);
+            linha = contLinha;
+            ok = guarda_token(fluxo, &t, linha);
+            fim = t.cat == FIM_ARQ;
+        }
     }
+
+    for (k = 0; k < num_trechos; k++) free(trechos[k].tokens);
+
+    if (!ok)
+    {
+        // Sem memória para os trechos ou para o fluxo: a leitura serial ainda pode dar certo
+        liberar_fluxo(fluxo);
+        return pre_analex(fd, fluxo);
+    }
+    fonte.cursor = p;
+    contLinha = linha;
+    return true;
 }
 
+#else
+
+bool pre_analex_paralelo(FILE *fd, FLUXO_TOKENS *fluxo, int num_threads)
+{
+    return pre_analex(fd, fluxo);
+}
+
+#endif
+
+void le_token_do_fluxo(const FLUXO_TOKENS *fluxo, int i, TOKEN *destino)
+{
+    int v = fluxo->valor[i];
+    destino->cat = fluxo->cat[i];
+    destino->nome = SEM_NOME;
+    destino->inicio = NULL;
+    destino->tamanho = 0;
+
+    switch (destino->cat)
+    {
+        case SN:
+        case PALAVRA_RESERVADA:
+            destino->codigo = fluxo->codigo[i];
+            break;
+        case ID:
+        case CT_STRING:
+            destino->nome = v;
+            destino->inicio = texto_nome(v);
+            destino->tamanho = tamanho_nome(v);
+            break;
+        case CT_INT:
+            destino->valInt = fluxo->valores[v].valInt;
+            break;
+        case CT_REAL:
+            destino->valReal = fluxo->valores[v].valReal;
+            break;
+        case CT_CHAR:
+        case CT_BN:
+        case CT_BZ:
+            destino->valInt = 0;
+            destino->lexema[0] = (char)fluxo->valores[v].valInt;
+            break;
+        default:
+            break;
+    }
+}
+
+void liberar_fluxo(FLUXO_TOKENS *fluxo)
+{
+    free(fluxo->cat);
+    free(fluxo->codigo);
+    free(fluxo->linha);
+    free(fluxo->valor);
+    free(fluxo->valores);
+    memset(fluxo, 0, sizeof(*fluxo));
+}
@@ -3,6 +3,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
+#include "tabela_nomes.h"
 
 /* CONSTANTES */
 #ifndef ANALEX
@@ -87,8 +88,38 @@ typedef struct
         int valInt;         // Para CT_INT
         double valReal;     // Para CT_REAL
     };
+    int nome;               // Para ID e CT_STRING: código do texto na tabela de nomes (ver tabela_nomes.h)
+    const char *inicio;     // Para ID e CT_STRING: o texto internado, igual a texto_nome(nome)
+    int tamanho;            // Quantidade de caracteres apontados por 'inicio'
 } TOKEN;
 
+/* Valor de uma constante guardada no fluxo de tokens */
+typedef union 
+{
+    int valInt;         // CT_INT e o caractere de CT_CHAR/CT_BN/CT_BZ
+    double valReal;     // CT_REAL
+} VALOR_TOKEN;
+
+/* 
+    Fluxo de tokens pré-analisados: o arquivo inteiro é lido uma única vez e cada token ocupa
+    uma posição em vários arrays paralelos (estrutura de arrays), 10 bytes por token.
+    O parser anda por índice, sem copiar TOKENs, e pode olhar qualquer token à frente.
+    Identificadores e strings guardam só o código do nome; o texto fica na tabela de nomes.
+*/
+typedef struct 
+{
+    int quantidade;             // Número de tokens (o último é sempre FIM_ARQ)
+    int capacidade;             // Posições reservadas em cada array
+    unsigned char *cat;         // Categoria (enum TOKEN_CAT)
+    unsigned char *codigo;      // Código para SN e PALAVRA_RESERVADA
+    int *linha;                 // Valor de contLinha depois da leitura do token
+    int *valor;                 // Código do nome (ID, CT_STRING) ou índice em 'valores' (constantes); -1 se não houver
+
+    VALOR_TOKEN *valores;       // Valores das constantes numéricas e de caractere
+    int num_valores;
+    int cap_valores;
+} FLUXO_TOKENS;
+
 /****************************** DECLARAÇÕES DE FUNÇÕES  ***********************************/
 
 /* 
@@ -129,9 +160,83 @@ void error(char msg[]);
 */
 int check_reserved_word(const char *lexema);
 
+/* 
+    Mesma verificação de check_reserved_word, para um lexema que não termina em '\0'
+    (por exemplo, um recorte do buffer da fonte). Usa um hash perfeito e uma única comparação.
+    @param: const char *inicio --> primeiro caractere do lexema
+    @param: int tamanho --> quantidade de caracteres do lexema
+    @return: int --> o código da palavra reservada ou 0 caso não seja palavra reservada.
+*/
+int check_reserved_span(const char *inicio, int tamanho);
+
+/* 
+    Função para copiar o texto de um token ID ou CT_STRING para um buffer terminado em '\0'.
+    O texto é truncado se não couber.
+    @param: const TOKEN *tk --> o token de onde o texto será lido
+    @param: char *destino --> buffer que receberá o texto
+    @param: int tam_destino --> tamanho do buffer de destino
+    @return: void
+*/
+void copia_lexema(const TOKEN *tk, char *destino, int tam_destino);
+
+/* 
+    Função para carregar todo o código-fonte em memória antes da análise.
+    Arquivos regulares são mapeados com mmap; pipes e afins são lidos em blocos grandes.
+    Depois de carregada, o Analex percorre o buffer com um cursor em vez de chamar fgetc.
+    @param: FILE *fd --> o arquivo já aberto, na posição onde a análise deve começar
+    @return: bool --> true se a fonte foi carregada; false mantém a leitura via fgetc
+*/
+bool carregar_fonte(FILE *fd);
+
+/* 
+    Função para liberar o buffer criado por carregar_fonte (munmap ou free).
+    Os textos de ID/CT_STRING ficam na tabela de nomes e continuam válidos.
+    @return: void
+*/
+void liberar_fonte();
+
+/* 
+    Função para ler o arquivo inteiro de uma vez e guardar todos os tokens em um FLUXO_TOKENS.
+    Carrega a fonte com carregar_fonte se isso ainda não foi feito.
+    @param: FILE *fd --> o arquivo a ser analisado
+    @param: FLUXO_TOKENS *fluxo --> o fluxo que será preenchido
+    @return: bool --> false se a fonte não pôde ser carregada ou faltou memória
+*/
+bool pre_analex(FILE *fd, FLUXO_TOKENS *fluxo);
+
+/* 
+    Mesmo resultado de pre_analex, lendo arquivos grandes em paralelo: a fonte é dividida em trechos
+    que começam em início de linha, cada trecho é lido por uma thread e os tokens são costurados em
+    ordem. Um trecho que começa dentro de um comentário é relido na costura até voltar a bater com a
+    leitura serial, então os tokens, os códigos de nome e as linhas são os mesmos de pre_analex.
+    @param: FILE *fd --> o arquivo a ser analisado
+    @param: FLUXO_TOKENS *fluxo --> o fluxo que será preenchido
+    @param: int num_threads --> quantidade de trechos/threads (menos de 2, ou arquivo pequeno, usa pre_analex)
+    @return: bool --> false se a fonte não pôde ser carregada ou faltou memória
+*/
+bool pre_analex_paralelo(FILE *fd, FLUXO_TOKENS *fluxo, int num_threads);
+
+/* 
+    Função para preencher um TOKEN com o i-ésimo token do fluxo (só os campos usados pela categoria).
+    @param: const FLUXO_TOKENS *fluxo --> o fluxo
+    @param: int i --> índice do token, de 0 a fluxo->quantidade - 1
+    @param: TOKEN *destino --> token que receberá os campos
+    @return: void
+*/
+void le_token_do_fluxo(const FLUXO_TOKENS *fluxo, int i, TOKEN *destino);
+
+/* 
+    Função para liberar os arrays de um FLUXO_TOKENS.
+    @param: FLUXO_TOKENS *fluxo --> o fluxo a ser liberado
+    @return: void
+*/
+void liberar_fluxo(FLUXO_TOKENS *fluxo);
+
 /* 
     Função Analex é a mais importante do código
-    Consome um arquivo e retorna o próximo token válido encontrado
+    Consome um arquivo e retorna o próximo token válido encontrado.
+    O AFD é dirigido por tabela: afd_tabela.h é gerado de AFD/afd.jff pelo gera_afd (ver compile.sh),
+    então qualquer mudança nos estados deve ser feita no diagrama.
     @param: FILE *fd --> um ponteiro apontando para o arquivo que será consumido
     @return: TOKEN --> o próximo token encontrado
 */
@@ -2,23 +2,36 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>// Necessário para strcat e strlen
+#include <string.h>
 #include "anasint.h"
 #include "analex.h"
 #include "tabela_simbolos.h" // Inclusão do header da tabela de símbolos
 #include "gerador_codigo.h"
+#include "rastro.h"
 
 // --- Variáveis Globais para Tabela de Símbolos ---
 TokenInfo tokenInfo; // Estrutura para armazenar informações do token atual
-Tabela tabela; // A tabela de símbolos
+// A tabela de símbolos ('tabela') é definida em tabela_simbolos.c
+
+// --- Fluxo de tokens pré-analisados (opcional) ---
+static FLUXO_TOKENS *fluxo_tokens = NULL; // Quando não é NULL, os tokens vêm do fluxo e não do Analex
+static int pos_token = -1;                // Índice do token atual ('t') no fluxo
+
+// --- Geração de código ---
+static bool descarta_valor = false;       // A próxima expressão é um comando: seu valor não é usado
+static TIPO tipo_funcao = NA_TIPO;        // Tipo de retorno da função sendo compilada
 
 // --- Protótipos de Funções ---
 void Prog();
 void Decl_ou_Func();
-void Func_body(int procPos);
+void Func_body(int procPos, int prototipo);
 void Decl();
 void Decl_var_body();
 void Decl_var();
+static void declara_variavel(int tamanho);
+static int gera_condicao();
+static void materializa();
+static void gera_retorno();
 int Tipo();
 void Tipos_param();
 void Cmd();
@@ -31,35 +44,6 @@ void Expr_aditiva();
 void Expr_multiplicativa();
 void Fator();
 
-/**
- * @brief Aumenta a indentação para a impressão da árvore sintática.
- */
-void aumenta_ident() { if (strlen(TABS) < sizeof(TABS) - 3) strcat(TABS, " "); }
-
-/**
- * @brief Diminui a indentação para a impressão da árvore sintática.
- */
-void diminui_ident() { if (strlen(TABS) >= 2) TABS[strlen(TABS) - 2] = '\0'; }
-
-/**
- * @brief Imprime um token formatado no console para fins de depuração.
- * @param tk O token a ser impresso.
- */
-void print_folha(TOKEN tk) 
-{
-    printf("%s- ", TABS);
-    switch (tk.cat) {
-        case ID: printf("ID: %s\n", tk.lexema); break;
-        case SN: printf("SN: %d\n", tk.codigo); break;
-        case CT_INT: printf("CT_INT: %d\n", tk.valInt); break;
-        case CT_REAL: printf("CT_REAL: %f\n", tk.valReal); break;
-        case CT_CHAR: printf("CT_CHAR: '%c'\n", tk.valInt); break;
-        case CT_STRING: printf("CT_STRING: \"%s\"\n", tk.lexema); break;
-        case PALAVRA_RESERVADA: printf("PR: %d\n", tk.codigo); break;
-        default: printf("TOKEN (cat %d)\n", tk.cat); break;
-    }
-}
-
 /**
  * @brief Converte um token (categoria e código) em uma descrição textual amigável.
  * @return Uma string constante (const char*) com a descrição do token.
@@ -119,20 +103,47 @@ const char* getTokenDescription(int category, int code) {
     }
 }
 
+/**
+ * @brief Faz o parser ler os tokens de um fluxo pré-analisado em vez de chamar o Analex.
+ * @param fluxo O fluxo preenchido por pre_analex (NULL volta a usar o Analex).
+ */
+void usar_fluxo_de_tokens(FLUXO_TOKENS *fluxo) {
+    fluxo_tokens = fluxo;
+    pos_token = -1;
+}
+
+/**
+ * @brief Avança 't' para o próximo token, vindo do fluxo (por índice) ou do Analex.
+ * No fluxo, 'contLinha' volta para a linha do token, então as mensagens de erro não mudam.
+ */
+void proximo_token() {
+    if (fluxo_tokens == NULL) {
+        t = Analex(fd);
+        return;
+    }
+    if (pos_token < fluxo_tokens->quantidade - 1) {
+        pos_token++;
+    }
+    le_token_do_fluxo(fluxo_tokens, pos_token, &t);
+    contLinha = fluxo_tokens->linha[pos_token];
+}
+
 /**
  * @brief Verifica se o token atual é o esperado e avança para o próximo.
  * Se o token não for o esperado, formata e exibe um erro detalhado.
  */
 void consome(int categoria_esperada, int codigo_esperado) {
     if (t.cat == categoria_esperada && (codigo_esperado == 0 || t.codigo == codigo_esperado)) {
-        t = Analex(fd);
+        proximo_token();
     } else {
         const char* desc_esperado = getTokenDescription(categoria_esperada, codigo_esperado);
         const char* desc_encontrado = getTokenDescription(t.cat, t.codigo);
         char msg_erro[256];
 
         if (t.cat == ID || t.cat == CT_STRING) {
-            sprintf(msg_erro, "Token inesperado. Esperado %s, mas encontrado %s ('%s').", desc_esperado, desc_encontrado, t.lexema);
+            char texto[TAM_MAX_LEXEMA];
+            copia_lexema(&t, texto, sizeof(texto));
+            sprintf(msg_erro, "Token inesperado. Esperado %s, mas encontrado %s ('%s').", desc_esperado, desc_encontrado, texto);
         } else if (t.cat == CT_INT) {
             sprintf(msg_erro, "Token inesperado. Esperado %s, mas encontrado %s (%d).", desc_esperado, desc_encontrado, t.valInt);
         } else if (t.cat == CT_REAL) {
@@ -160,13 +171,25 @@ int Tipo() {
     return 0;
 }
 
+/**
+ * @brief Insere na tabela a variável descrita em `tokenInfo` e reserva suas células:
+ * no segmento de dados, se é global, ou no quadro da função, se é local ou parâmetro.
+ * @param tamanho Elementos, se é um vetor (0 = escalar; -1 = parâmetro vetor).
+ */
+static void declara_variavel(int tamanho) {
+    int celulas = tamanho > 0 ? tamanho : 1;
+    tokenInfo.tamanho = tamanho;
+    tokenInfo.endereco = tokenInfo.idcategoria == VAR_GLOBAL ? aloca_global(celulas) : aloca_local(celulas);
+    inserirNaTabela(tokenInfo);
+}
+
 /**
  * @brief Ponto de entrada do analisador sintático. Analisa o programa inteiro.
  * Gramática: `prog ::= { decl ';' | func }`
  */
 void Prog() {
-    printf("%s<Prog>\n", TABS); aumenta_ident();
-    t = Analex(fd);
+    ABRE_REGRA("Prog");
+    proximo_token();
     while (t.cat != FIM_ARQ) {
         if (Tipo() || (t.cat == PALAVRA_RESERVADA && t.codigo == PR_VOID)) {
             tokenInfo.escopo = GLOBAL;
@@ -175,57 +198,83 @@ void Prog() {
             error("Esperado uma declaracao de variavel ou definicao de funcao no escopo global.");
         }
     }
+    instantaneoTabela("fim_programa", SEM_NOME);
     limparTabela();
-    diminui_ident(); printf("%s</Prog>\n", TABS);
+    FECHA_REGRA("Prog");
 }
 
 /**
  * @brief Distingue entre uma declaração de variável e uma de função.
  */
 void Decl_ou_Func() {
-    printf("%s<Decl_ou_Func>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Decl_ou_Func");
     int tipo_atual = tokenInfo.tipo;
     if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_VOID) {
         tipo_atual = NA_TIPO;
     }
     
-    print_folha(t); consome(t.cat, t.codigo);
-    strcpy(tokenInfo.lexema, t.lexema);
+    FOLHA(t); consome(t.cat, t.codigo);
+    tokenInfo.nome = t.nome;
     tokenInfo.tipo = tipo_atual;
-    print_folha(t); consome(ID, 0);
+    FOLHA(t); consome(ID, 0);
 
     if (t.cat == SN && t.codigo == ABRE_PARENTESES) {
         tokenInfo.idcategoria = PROC;
+        tokenInfo.endereco = -1;
+        tokenInfo.tamanho = 0;
+        int anterior = buscaLexPos(tokenInfo.nome); // Um protótipo da mesma função, se houver
         int func_pos = tabela.topo;
         inserirNaTabela(tokenInfo);
-        Func_body(func_pos);
+        Func_body(func_pos, anterior >= 0 && tabela.tokensTab[anterior].idcategoria == PROT_ ? anterior : -1);
     } else {
         tokenInfo.idcategoria = VAR_GLOBAL;
-        inserirNaTabela(tokenInfo);
         Decl_var_body();
     }
-    diminui_ident(); printf("%s</Decl_ou_Func>\n", TABS);
+    FECHA_REGRA("Decl_ou_Func");
+}
+
+// A definição de uma função declarada antes por um protótipo repete o tipo de retorno e os
+// parâmetros dele
+static void confere_prototipo(int prototipo, int funcao) {
+    const TokenInfo *simbolos = tabela.tokensTab;
+    bool igual = simbolos[prototipo].tipo == simbolos[funcao].tipo;
+    int i = 1;
+    for (; igual && funcao + i < tabela.topo && simbolos[funcao + i].idcategoria == PROC_PAR; i++) {
+        igual = simbolos[prototipo + i].idcategoria == PROC_PAR && simbolos[prototipo + i].tipo == simbolos[funcao + i].tipo
+                && simbolos[prototipo + i].tamanho == simbolos[funcao + i].tamanho;
+    }
+    if (!igual || simbolos[prototipo + i].idcategoria == PROC_PAR) error("Definicao de funcao difere do prototipo.");
 }
 
 /**
  * @brief Analisa o corpo e os parâmetros de uma função.
- * Gramática: `func ::= tipo id '(' tipos_param ')' '{' ... '}'`
+ * Gramática: `func ::= tipo id '(' tipos_param ')' ( ';' | '{' ... '}' )`
+ * Um protótipo (terminado em ';') fica na tabela como PROT_, para as chamadas que vêm antes
+ * da definição, e os seus parâmetros saem de escopo logo em seguida.
+ * @param prototipo Posição do protótipo anterior da mesma função, ou -1.
  */
-void Func_body(int procPos) {
-    printf("%s<Func_body>\n", TABS); aumenta_ident();
-    print_folha(t); consome(SN, ABRE_PARENTESES);
+void Func_body(int procPos, int prototipo) {
+    ABRE_REGRA("Func_body");
+    FOLHA(t); consome(SN, ABRE_PARENTESES);
     tokenInfo.escopo = LOCAL;
+    inicia_quadro();
     
     if (t.cat != SN || t.codigo != FECHA_PARENTESES) {
         Tipos_param();
     }
     
-    print_folha(t); consome(SN, FECHA_PARENTESES);
+    FOLHA(t); consome(SN, FECHA_PARENTESES);
+    if (prototipo >= 0) confere_prototipo(prototipo, procPos);
     
     if (t.cat == SN && t.codigo == PONTO_VIRGULA) {
-        print_folha(t); consome(SN, PONTO_VIRGULA);
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
+        tabela.tokensTab[procPos].idcategoria = PROT_;
+        matarZumbis(procPos);
     } else {
-        print_folha(t); consome(SN, ABRE_CHAVES);
+        FOLHA(t); consome(SN, ABRE_CHAVES);
+        int marca_locais = marcarEscopo();
+        inicia_funcao(tabela.tokensTab[procPos].nome, marca_locais - procPos - 1, tabela.tokensTab[procPos].tipo != NA_TIPO);
+        tipo_funcao = tabela.tokensTab[procPos].tipo;
         while (Tipo()) {
             tokenInfo.idcategoria = VAR_LOCAL;
             Decl();
@@ -233,30 +282,36 @@ void Func_body(int procPos) {
         while (!(t.cat == SN && t.codigo == FECHA_CHAVES)) {
             Cmd();
         }
-        print_folha(t); consome(SN, FECHA_CHAVES);
+        termina_funcao();
+        FOLHA(t); consome(SN, FECHA_CHAVES);
+        instantaneoTabela("fim_funcao", tabela.tokensTab[procPos].nome);
         matarZumbis(procPos);
-        retirarLocais();
+        restaurarEscopo(marca_locais);
     }
-    diminui_ident(); printf("%s</Func_body>\n", TABS);
+    FECHA_REGRA("Func_body");
 }
 
 /**
- * @brief Analisa o restante de uma linha de declaração de variáveis.
+ * @brief Analisa o restante de uma linha de declaração de variáveis
+ * (a primeira variável, cujo nome já foi consumido, entra na tabela aqui).
  */
 void Decl_var_body() {
-    printf("%s<Decl_var_body>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Decl_var_body");
+    int tamanho = 0;
     if (t.cat == SN && t.codigo == ABRE_COLCHETES) {
-        print_folha(t); consome(SN, ABRE_COLCHETES);
-        print_folha(t); consome(CT_INT, 0);
-        print_folha(t); consome(SN, FECHA_COLCHETES);
+        FOLHA(t); consome(SN, ABRE_COLCHETES);
+        tamanho = t.valInt;
+        FOLHA(t); consome(CT_INT, 0);
+        FOLHA(t); consome(SN, FECHA_COLCHETES);
     }
+    declara_variavel(tamanho);
     
     while (t.cat == SN && t.codigo == VIRGULA) {
-        print_folha(t); consome(SN, VIRGULA);
+        FOLHA(t); consome(SN, VIRGULA);
         Decl_var();
     }
-    print_folha(t); consome(SN, PONTO_VIRGULA);
-    diminui_ident(); printf("%s</Decl_var_body>\n", TABS);
+    FOLHA(t); consome(SN, PONTO_VIRGULA);
+    FECHA_REGRA("Decl_var_body");
 }
 
 /**
@@ -264,24 +319,24 @@ void Decl_var_body() {
  * Gramática: `decl ::= tipo decl_var { ',' decl_var } ';'`
  */
 void Decl() {
-    printf("%s<Decl>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Decl");
     if (Tipo()) {
         int tipo_linha = tokenInfo.tipo;
-        print_folha(t); consome(t.cat, t.codigo);
+        FOLHA(t); consome(t.cat, t.codigo);
         tokenInfo.tipo = tipo_linha;
         Decl_var();
         
         while (t.cat == SN && t.codigo == VIRGULA) {
-            print_folha(t); consome(SN, VIRGULA);
+            FOLHA(t); consome(SN, VIRGULA);
             tokenInfo.tipo = tipo_linha;
             tokenInfo.idcategoria = VAR_LOCAL;
             Decl_var();
         }
-        print_folha(t); consome(SN, PONTO_VIRGULA);
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
     } else {
         error("Esperado uma declaracao de variavel local.");
     }
-    diminui_ident(); printf("%s</Decl>\n", TABS);
+    FECHA_REGRA("Decl");
 }
 
 /**
@@ -289,17 +344,19 @@ void Decl() {
  * Gramática: `decl_var ::= id [ '[' intcon ']' ]`
  */
 void Decl_var() {
-    printf("%s<Decl_var>\n", TABS); aumenta_ident();
-    strcpy(tokenInfo.lexema, t.lexema);
-    print_folha(t); consome(ID, 0);
+    ABRE_REGRA("Decl_var");
+    tokenInfo.nome = t.nome;
+    FOLHA(t); consome(ID, 0);
 
+    int tamanho = 0;
     if (t.cat == SN && t.codigo == ABRE_COLCHETES) {
-        print_folha(t); consome(SN, ABRE_COLCHETES);
-        print_folha(t); consome(CT_INT, 0);
-        print_folha(t); consome(SN, FECHA_COLCHETES);
+        FOLHA(t); consome(SN, ABRE_COLCHETES);
+        tamanho = t.valInt;
+        FOLHA(t); consome(CT_INT, 0);
+        FOLHA(t); consome(SN, FECHA_COLCHETES);
     }
-    inserirNaTabela(tokenInfo);
-    diminui_ident(); printf("%s</Decl_var>\n", TABS);
+    declara_variavel(tamanho);
+    FECHA_REGRA("Decl_var");
 }
 
 /**
@@ -307,34 +364,36 @@ void Decl_var() {
  * Gramática: `tipos_param ::= void | tipo (id | id '['']') { ',' ... }`
  */
 void Tipos_param() {
-    printf("%s<Tipos_param>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Tipos_param");
     if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_VOID) {
-        print_folha(t); consome(PALAVRA_RESERVADA, PR_VOID);
+        FOLHA(t); consome(PALAVRA_RESERVADA, PR_VOID);
     } else {
         while (Tipo()) {
             int tipo_param = tokenInfo.tipo;
-            print_folha(t); consome(t.cat, t.codigo);
+            FOLHA(t); consome(t.cat, t.codigo);
             
             tokenInfo.tipo = tipo_param;
             tokenInfo.idcategoria = PROC_PAR;
             tokenInfo.escopo = LOCAL;
-            strcpy(tokenInfo.lexema, t.lexema);
-            print_folha(t); consome(ID, 0);
+            tokenInfo.nome = t.nome;
+            FOLHA(t); consome(ID, 0);
 
+            int tamanho = 0;
             if (t.cat == SN && t.codigo == ABRE_COLCHETES) {
-                print_folha(t); consome(SN, ABRE_COLCHETES);
-                print_folha(t); consome(SN, FECHA_COLCHETES);
+                FOLHA(t); consome(SN, ABRE_COLCHETES);
+                FOLHA(t); consome(SN, FECHA_COLCHETES);
+                tamanho = -1;
             }
-            inserirNaTabela(tokenInfo);
+            declara_variavel(tamanho);
 
             if (t.cat == SN && t.codigo == VIRGULA) {
-                print_folha(t); consome(SN, VIRGULA);
+                FOLHA(t); consome(SN, VIRGULA);
             } else {
                 break;
             }
         }
     }
-    diminui_ident(); printf("%s</Tipos_param>\n", TABS);
+    FECHA_REGRA("Tipos_param");
 }
 
 /**
@@ -343,232 +402,660 @@ void Tipos_param() {
  */
 void Cmd() 
 {
-    printf("%s<Cmd>\n", TABS); aumenta_ident();
-    char linha[100]; // Buffer para gerar instruções
+    ABRE_REGRA("Cmd");
 
     if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_IF) {
-        print_folha(t); consome(PALAVRA_RESERVADA, PR_IF);
-        print_folha(t); consome(SN, ABRE_PARENTESES);
+        FOLHA(t); consome(PALAVRA_RESERVADA, PR_IF);
+        FOLHA(t); consome(SN, ABRE_PARENTESES);
 
-        Expr(); // Gera código para a condição do if
+        // Gera código para a condição do if: se ela for falsa, salta para o rótulo do else.
+        int rotulo_else = gera_condicao();
 
-        print_folha(t); consome(SN, FECHA_PARENTESES);
+        FOLHA(t); consome(SN, FECHA_PARENTESES);
 
-        int rotulo_else = novo_rotulo();
         int rotulo_fim = novo_rotulo();
 
-        // Se a condição for falsa (0), salta para o rótulo do else.
-        sprintf(linha, "GOFALSE L%d", rotulo_else);
-        gera(linha);
-
         Cmd(); // Corpo do if (bloco 'then')
 
         if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_ELSE) {
             // Se houver 'else', o bloco 'then' precisa saltar para o fim do if.
-            sprintf(linha, "GOTO L%d", rotulo_fim);
-            gera(linha);
+            gera_desvio(OP_GOTO, rotulo_fim);
 
             // Gera o rótulo para o início do bloco 'else'.
-            sprintf(linha, "LABEL L%d", rotulo_else);
-            gera(linha);
+            gera_rotulo(rotulo_else);
 
-            print_folha(t); consome(PALAVRA_RESERVADA, PR_ELSE);
+            FOLHA(t); consome(PALAVRA_RESERVADA, PR_ELSE);
             Cmd(); // Corpo do else
 
             // Gera o rótulo para o fim da estrutura if-else.
-            sprintf(linha, "LABEL L%d", rotulo_fim);
-            gera(linha);
+            gera_rotulo(rotulo_fim);
         } else {
             // Se não houver 'else', o 'GOFALSE' salta para este rótulo.
-            sprintf(linha, "LABEL L%d", rotulo_else);
-            gera(linha);
+            gera_rotulo(rotulo_else);
         }
 
     } else if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_WHILE) {
-        print_folha(t); consome(PALAVRA_RESERVADA, PR_WHILE);
-        print_folha(t); consome(SN, ABRE_PARENTESES);
+        FOLHA(t); consome(PALAVRA_RESERVADA, PR_WHILE);
+        FOLHA(t); consome(SN, ABRE_PARENTESES);
 
         int rotulo_inicio = novo_rotulo();
-        int rotulo_fim = novo_rotulo();
 
         // Gera o rótulo para o início do loop (teste da condição).
-        sprintf(linha, "LABEL L%d", rotulo_inicio);
-        gera(linha);
-
-        Expr(); // Gera código para a condição
+        gera_rotulo(rotulo_inicio);
 
-        print_folha(t); consome(SN, FECHA_PARENTESES);
+        // Gera código para a condição: se ela for falsa, salta para o fim do loop.
+        int rotulo_fim = gera_condicao();
 
-        // Se a condição for falsa, salta para o fim do loop.
-        sprintf(linha, "GOFALSE L%d", rotulo_fim);
-        gera(linha);
+        FOLHA(t); consome(SN, FECHA_PARENTESES);
 
         Cmd(); // Corpo do while
 
         // Salta de volta para o início para reavaliar a condição.
-        sprintf(linha, "GOTO L%d", rotulo_inicio);
-        gera(linha);
+        gera_desvio(OP_GOTO, rotulo_inicio);
 
         // Gera o rótulo de fim do loop.
-        sprintf(linha, "LABEL L%d", rotulo_fim);
-        gera(linha);
+        gera_rotulo(rotulo_fim);
 
     } else if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_FOR) {
-        // NOTA: A estrutura deste parser para o 'for' é problemática.
-        // Ele processa a parte de incremento (C) ANTES do corpo do loop (D)
-        // em um laço for(A; B; C) { D; }. A ordem de execução correta seria A, B, D, C.
-        // A ordem do parser leva a uma geração de código incorreta: A, B, C, D.
-        // Para uma implementação correta, a estrutura do parser precisaria ser
-        // modificada para adiar a geração de código da parte de incremento.
-        // O código abaixo apenas analisa a sintaxe sem gerar código funcional.
-        
-        printf("%s- AVISO: A geracao de codigo para o laco 'for' nao foi implementada devido a uma limitacao estrutural do parser.\n", TABS);
-        
-        print_folha(t); consome(PALAVRA_RESERVADA, PR_FOR);
-        print_folha(t); consome(SN, ABRE_PARENTESES);
-        if (t.cat != SN || t.codigo != PONTO_VIRGULA) { Expr_atrib(); }
-        print_folha(t); consome(SN, PONTO_VIRGULA);
-        if (t.cat != SN || t.codigo != PONTO_VIRGULA) { Expr(); }
-        print_folha(t); consome(SN, PONTO_VIRGULA);
-        if (t.cat != SN || t.codigo != FECHA_PARENTESES) { Expr_atrib(); }
-        print_folha(t); consome(SN, FECHA_PARENTESES);
-        Cmd();
+        // for (A; B; C) D executa A; enquanto B, D e depois C. O código do incremento C é
+        // gerado quando ele é lido, antes do corpo, então é recortado e volta depois de D.
+        FOLHA(t); consome(PALAVRA_RESERVADA, PR_FOR);
+        FOLHA(t); consome(SN, ABRE_PARENTESES);
+        if (t.cat != SN || t.codigo != PONTO_VIRGULA) { descarta_valor = true; Expr_atrib(); }
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
+
+        int rotulo_inicio = novo_rotulo();
+        gera_rotulo(rotulo_inicio);
+
+        // Sem condição, o laço só termina com um return
+        int rotulo_fim = t.cat != SN || t.codigo != PONTO_VIRGULA ? gera_condicao() : novo_rotulo();
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
+
+        int inicio_incremento = codigo.quantidade, tam_incremento = 0;
+        if (t.cat != SN || t.codigo != FECHA_PARENTESES) { descarta_valor = true; Expr_atrib(); }
+        INSTRUCAO *incremento = recorta_codigo_desde(inicio_incremento, &tam_incremento);
+        FOLHA(t); consome(SN, FECHA_PARENTESES);
+
+        Cmd(); // Corpo do for
+
+        gera_trecho(incremento, tam_incremento);
+        free(incremento);
+        gera_desvio(OP_GOTO, rotulo_inicio);
+        gera_rotulo(rotulo_fim);
 
     } else if (t.cat == PALAVRA_RESERVADA && t.codigo == PR_RETURN) {
-        print_folha(t); consome(PALAVRA_RESERVADA, PR_RETURN);
+        FOLHA(t); consome(PALAVRA_RESERVADA, PR_RETURN);
         if (t.cat != SN || t.codigo != PONTO_VIRGULA) {
-            Expr(); // Gera código para a expressão de retorno (o valor fica no topo da pilha)
+            gera_retorno(); // Gera código para a expressão de retorno (o valor fica no topo da pilha)
         }
-        print_folha(t); consome(SN, PONTO_VIRGULA);
-        gera("RET"); // Gera a instrução de retorno do procedimento
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
+        gera(OP_RET); // Gera a instrução de retorno do procedimento
 
     } else if (t.cat == SN && t.codigo == ABRE_CHAVES) {
-        print_folha(t); consome(SN, ABRE_CHAVES);
+        FOLHA(t); consome(SN, ABRE_CHAVES);
         while (!(t.cat == SN && t.codigo == FECHA_CHAVES)) {
             Cmd();
         }
-        print_folha(t); consome(SN, FECHA_CHAVES);
+        FOLHA(t); consome(SN, FECHA_CHAVES);
 
     } else if (t.cat == SN && t.codigo == PONTO_VIRGULA) {
         // Comando vazio
-        print_folha(t); consome(SN, PONTO_VIRGULA);
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
 
     } else {
-        // Comando de expressão (ex: atribuição ou chamada de função)
+        // Comando de expressão (ex: atribuição ou chamada de função): o valor é descartado
+        descarta_valor = true;
         Expr();
-        print_folha(t); consome(SN, PONTO_VIRGULA);
+        FOLHA(t); consome(SN, PONTO_VIRGULA);
+    }
+
+    FECHA_REGRA("Cmd");
+}
+
+// --- Tipos das expressões ---
+// Toda expressão tem um tipo conhecido na compilação, tirado das constantes e da tabela de
+// símbolos (variáveis, parâmetros e retorno das funções). As operações aritméticas geram a
+// instrução do tipo dos operandos (IADD ou FADD, ...); quando um inteiro encontra um real,
+// só o inteiro ganha um I2F. Operar com uma string ou com uma função void é erro aqui.
+
+typedef enum {
+    TIPO_INTEIRO,   // int, char e bool
+    TIPO_REAL,
+    TIPO_TEXTO,     // Constante string (e o vetor recebido como parâmetro, que a carrega)
+    TIPO_NENHUM     // Chamada de função void: não deixa valor
+} TIPO_EXPR;
+
+static TIPO_EXPR tipo_de(TIPO tipo) {
+    return tipo == REAL_ ? TIPO_REAL : tipo == NA_TIPO ? TIPO_NENHUM : TIPO_INTEIRO;
+}
+
+// --- Dobra de constantes ---
+// Cada regra de expressão deixa em 'ultima_expr' o tipo do valor que o seu código calcula e
+// se esse código é só o PUSH de uma constante. Um operador cujos operandos são ambos
+// constantes descarta esses PUSHes e gera um único PUSH com o resultado, calculado como a
+// máquina calcularia.
+
+typedef struct {
+    bool constante;     // O código da expressão é um único PUSH, a partir de 'inicio'
+    TIPO_EXPR tipo;
+    int inicio;
+    int inteiro;
+    double valor_real;
+    bool relacao_real;  // O código termina numa comparação entre reais (ver para_desvio)
+} EXPR_CONSTANTE;
+
+static EXPR_CONSTANTE ultima_expr;
+
+// Rótulo falso da última expressão, se ela ficou em forma de desvio (ver adiante); -1 se ela deixou um valor
+static int ultimo_falso = -1;
+
+static void expr_nao_constante(TIPO_EXPR tipo) {
+    ultima_expr.constante = false;
+    ultima_expr.tipo = tipo;
+    ultima_expr.relacao_real = false;
+    ultimo_falso = -1;
+}
+
+static void expr_constante_inteira(int inicio, int valor) {
+    ultima_expr = (EXPR_CONSTANTE){ true, TIPO_INTEIRO, inicio, valor, 0, false };
+    ultimo_falso = -1;
+}
+
+static void expr_constante_real(int inicio, double valor) {
+    ultima_expr = (EXPR_CONSTANTE){ true, TIPO_REAL, inicio, 0, valor, false };
+    ultimo_falso = -1;
+}
+
+static double como_real(const EXPR_CONSTANTE *c) {
+    return c->tipo == TIPO_REAL ? c->valor_real : (double)c->inteiro;
+}
+
+static bool verdadeira(const EXPR_CONSTANTE *c) {
+    return c->tipo == TIPO_REAL ? c->valor_real != 0.0 : c->inteiro != 0;
+}
+
+// Substitui o código de uma expressão constante (a partir de 'inicio') pelo PUSH do resultado
+static void gera_constante_dobrada(int inicio, const EXPR_CONSTANTE *resultado) {
+    descarta_codigo_desde(inicio);
+    if (resultado->tipo == TIPO_REAL) {
+        gera_real(resultado->valor_real);
+        expr_constante_real(inicio, resultado->valor_real);
+    } else {
+        gera_int(OP_PUSH_INT, resultado->inteiro);
+        expr_constante_inteira(inicio, resultado->inteiro);
+    }
+}
+
+// A última expressão deixou um valor (não é a chamada de uma função void)
+static void exige_valor() {
+    if (ultima_expr.tipo == TIPO_NENHUM) error("Funcao void usada como valor.");
+}
+
+// O valor da última expressão é um número, inteiro ou real
+static void exige_numero() {
+    exige_valor();
+    if (ultima_expr.tipo == TIPO_TEXTO) error("String usada em uma operacao numerica.");
+}
+
+// Converte o número da última expressão para o tipo 'destino' (TIPO_INTEIRO ou TIPO_REAL):
+// uma constante é reescrita; outro valor ganha um I2F ou um F2I
+static void converte_para(TIPO_EXPR destino) {
+    if (ultima_expr.tipo == destino) return;
+    if (ultima_expr.constante && destino == TIPO_REAL) {
+        EXPR_CONSTANTE resultado = { true, TIPO_REAL, ultima_expr.inicio, 0, ultima_expr.inteiro, false };
+        gera_constante_dobrada(ultima_expr.inicio, &resultado);
+    } else if (ultima_expr.constante && ultima_expr.valor_real > -2147483649.0 && ultima_expr.valor_real < 2147483648.0) {
+        EXPR_CONSTANTE resultado = { true, TIPO_INTEIRO, ultima_expr.inicio, (int)ultima_expr.valor_real, 0, false };
+        gera_constante_dobrada(ultima_expr.inicio, &resultado);
+    } else { // Inclusive um real constante fora da faixa de int: o erro fica para a execução
+        gera(destino == TIPO_REAL ? OP_I2F : OP_F2I);
+        expr_nao_constante(destino);
     }
+}
 
-    diminui_ident(); printf("%s</Cmd>\n", TABS);
+// Converte para real o operando da esquerda de um operador binário, cujo código termina em
+// 'meio', onde começa o da direita: o PUSH de uma constante vira o PUSH do real; senão, o
+// código da direita é recortado para o I2F entrar entre os dois
+static void converte_esquerda(EXPR_CONSTANTE *esquerda, int meio) {
+    esquerda->tipo = TIPO_REAL;
+    if (esquerda->constante) {
+        esquerda->valor_real = esquerda->inteiro;
+        codigo.instrucoes[esquerda->inicio].op = OP_PUSH_REAL;
+        codigo.instrucoes[esquerda->inicio].arg.real = esquerda->valor_real;
+        return;
+    }
+    int tam_direita = 0;
+    INSTRUCAO *direita = recorta_codigo_desde(meio, &tam_direita);
+    gera(OP_I2F);
+    gera_trecho(direita, tam_direita);
+    free(direita);
+    ultima_expr.inicio++;
+}
+
+// Instrução de um operador binário (código do sinal no Analex), para operandos do tipo 'tipo'
+static OPCODE opcode_do_operador(int op, TIPO_EXPR tipo) {
+    bool real = tipo == TIPO_REAL;
+    switch (op) {
+        case SN_SOMA: return real ? OP_FADD : OP_IADD;
+        case SN_SUBTRACAO: return real ? OP_FSUB : OP_ISUB;
+        case SN_MULTIPLICACAO: return real ? OP_FMUL : OP_IMUL;
+        case SN_DIVISAO: return real ? OP_FDIV : OP_IDIV;
+        case SN_COMPARACAO: return OP_EQ;
+        case SN_DIFERENTE: return OP_NE;
+        case SN_MENOR: return OP_LT;
+        case SN_MAIOR: return OP_GT;
+        case SN_MENOR_IGUAL: return OP_LE;
+        case SN_MAIOR_IGUAL: return OP_GE;
+        case SN_AND: return OP_AND;
+        default: return OP_OR;
+    }
+}
+
+// Calcula 'a op b' com a aritmética da máquina (inteiros dão a volta, real se um dos dois é real).
+// Retorna false se o resultado tem de ficar para a execução (divisão inteira por zero).
+static bool avalia_binaria(int op, const EXPR_CONSTANTE *a, const EXPR_CONSTANTE *b, EXPR_CONSTANTE *r) {
+    bool real = a->tipo == TIPO_REAL || b->tipo == TIPO_REAL;
+    double x = como_real(a), y = como_real(b);
+    unsigned i = (unsigned)a->inteiro, j = (unsigned)b->inteiro;
+    *r = (EXPR_CONSTANTE){ true, TIPO_INTEIRO, a->inicio, 0, 0, false };
+    switch (op) {
+        case SN_SOMA: case SN_SUBTRACAO: case SN_MULTIPLICACAO: case SN_DIVISAO:
+            if (real) {
+                r->tipo = TIPO_REAL;
+                r->valor_real = op == SN_SOMA ? x + y : op == SN_SUBTRACAO ? x - y : op == SN_MULTIPLICACAO ? x * y : x / y;
+            } else if (op == SN_SOMA) {
+                r->inteiro = (int)(i + j);
+            } else if (op == SN_SUBTRACAO) {
+                r->inteiro = (int)(i - j);
+            } else if (op == SN_MULTIPLICACAO) {
+                r->inteiro = (int)(i * j);
+            } else {
+                if (b->inteiro == 0) return false;
+                r->inteiro = b->inteiro == -1 ? (int)(0u - i) : a->inteiro / b->inteiro;
+            }
+            return true;
+        case SN_COMPARACAO: r->inteiro = real ? x == y : a->inteiro == b->inteiro; return true;
+        case SN_DIFERENTE: r->inteiro = real ? x != y : a->inteiro != b->inteiro; return true;
+        case SN_MENOR: r->inteiro = real ? x < y : a->inteiro < b->inteiro; return true;
+        case SN_MAIOR: r->inteiro = real ? x > y : a->inteiro > b->inteiro; return true;
+        case SN_MENOR_IGUAL: r->inteiro = real ? x <= y : a->inteiro <= b->inteiro; return true;
+        case SN_MAIOR_IGUAL: r->inteiro = real ? x >= y : a->inteiro >= b->inteiro; return true;
+        case SN_AND: r->inteiro = verdadeira(a) && verdadeira(b); return true;
+        default: r->inteiro = verdadeira(a) || verdadeira(b); return true;
+    }
+}
+
+// Ação semântica de um operador aritmético ou relacional, depois de gerado o código dos dois
+// operandos (o da esquerda, um número já na pilha, termina em 'meio'). Se um dos dois é real,
+// o outro é convertido, e a operação é a do tipo comum.
+static void gera_operador_binario(int op, EXPR_CONSTANTE *esquerda, int meio) {
+    EXPR_CONSTANTE resultado;
+    materializa();
+    exige_numero();
+    TIPO_EXPR tipo = esquerda->tipo == TIPO_REAL || ultima_expr.tipo == TIPO_REAL ? TIPO_REAL : TIPO_INTEIRO;
+    converte_para(tipo);
+    if (esquerda->tipo != tipo) converte_esquerda(esquerda, meio);
+    if (esquerda->constante && ultima_expr.constante && avalia_binaria(op, esquerda, &ultima_expr, &resultado)) {
+        gera_constante_dobrada(esquerda->inicio, &resultado);
+    } else {
+        bool aritmetico = op == SN_SOMA || op == SN_SUBTRACAO || op == SN_MULTIPLICACAO || op == SN_DIVISAO;
+        gera(opcode_do_operador(op, tipo));
+        expr_nao_constante(aritmetico ? tipo : TIPO_INTEIRO);
+        ultima_expr.relacao_real = !aritmetico && tipo == TIPO_REAL;
+    }
+}
+
+// --- Expressões lógicas: código de desvio ---
+// Uma expressão com && ou || não calcula um 0 ou 1: seu código continua na instrução seguinte
+// quando ela é verdadeira e desvia para o rótulo 'ultimo_falso' (ainda não colocado) quando é
+// falsa, e o operando da direita só é avaliado se o da esquerda não decide o resultado. if e
+// while usam esses desvios direto; quem precisa do valor chama materializa().
+
+static OPCODE desvio_inverso(OPCODE op) {
+    switch (op) {
+        case OP_GOFALSE: return OP_GOTRUE;
+        case OP_GOTRUE: return OP_GOFALSE;
+        case OP_JEQ: return OP_JNE;
+        case OP_JNE: return OP_JEQ;
+        case OP_JLT: return OP_JGE;
+        case OP_JGE: return OP_JLT;
+        case OP_JGT: return OP_JLE;
+        default: return OP_JGT;
+    }
+}
+
+static bool desvio_condicional(OPCODE op) {
+    return e_desvio(op) && op != OP_GOTO;
+}
+
+// Desvio que, fundido com a comparação 'op' (EQ .. GE), é tomado quando ela é falsa; OP_GOFALSE
+// se 'op' não é uma comparação
+static OPCODE desvio_se_falsa(OPCODE op) {
+    switch (op) {
+        case OP_EQ: return OP_JNE;
+        case OP_NE: return OP_JEQ;
+        case OP_LT: return OP_JGE;
+        case OP_GT: return OP_JLE;
+        case OP_LE: return OP_JGT;
+        case OP_GE: return OP_JLT;
+        default: return OP_GOFALSE;
+    }
+}
+
+// Algum desvio a partir da instrução 'inicio' vai para o rótulo r?
+static bool rotulo_usado(int inicio, int r) {
+    for (int i = inicio; i < codigo.quantidade; i++) {
+        if (e_desvio(codigo.instrucoes[i].op) && codigo.instrucoes[i].arg.rotulo == r) return true;
+    }
+    return false;
+}
+
+// Os desvios para o rótulo 'de', a partir da instrução 'inicio', passam a ir para 'para'
+static void redireciona(int inicio, int de, int para) {
+    for (int i = inicio; i < codigo.quantidade; i++) {
+        if (e_desvio(codigo.instrucoes[i].op) && codigo.instrucoes[i].arg.rotulo == de) codigo.instrucoes[i].arg.rotulo = para;
+    }
+}
+
+// Põe a última expressão em forma de desvio (um valor vira um GOFALSE); retorna o rótulo falso.
+// Uma comparação entre inteiros no fim da expressão é fundida com o desvio ('a; b; LT; GOFALSE'
+// é 'a; b; JGE'); entre reais, não: com um NaN, um desvio fundido não poderia ser invertido
+// trocando a relação, porque LT e GE são ambos falsos.
+static int para_desvio() {
+    if (ultimo_falso < 0) {
+        exige_valor();
+        int falso = novo_rotulo();
+        OPCODE desvio = OP_GOFALSE;
+        if (codigo.quantidade > 0 && !ultima_expr.constante && codigo.instrucoes[codigo.quantidade - 1].op == OP_NOT) {
+            descarta_codigo_desde(codigo.quantidade - 1); // 'x; NOT; GOFALSE' é 'x; GOTRUE'
+            desvio = OP_GOTRUE;
+        }
+        if (codigo.quantidade > 0 && !ultima_expr.constante && !ultima_expr.relacao_real
+            && desvio_se_falsa(codigo.instrucoes[codigo.quantidade - 1].op) != OP_GOFALSE) {
+            OPCODE fundido = desvio_se_falsa(codigo.instrucoes[codigo.quantidade - 1].op);
+            descarta_codigo_desde(codigo.quantidade - 1);
+            desvio = desvio == OP_GOFALSE ? fundido : desvio_inverso(fundido);
+        }
+        gera_desvio(desvio, falso);
+        expr_nao_constante(TIPO_INTEIRO);
+        ultimo_falso = falso;
+    }
+    return ultimo_falso;
+}
+
+// Troca o sentido da última expressão, em forma de desvio e começando em 'inicio': o código
+// passa a desviar para 'destino' quando ela é verdadeira e a continuar quando é falsa. Se ela
+// termina no desvio para o seu rótulo falso, basta inverter esse desvio; senão, entra um GOTO.
+static void inverte_desvio(int inicio, int destino) {
+    int falso = ultimo_falso;
+    INSTRUCAO *ultima = &codigo.instrucoes[codigo.quantidade - 1];
+    if (desvio_condicional(ultima->op) && ultima->arg.rotulo == falso) {
+        ultima->op = desvio_inverso(ultima->op);
+        ultima->arg.rotulo = destino;
+        if (rotulo_usado(inicio, falso)) gera_rotulo(falso);
+    } else {
+        gera_desvio(OP_GOTO, destino);
+        gera_rotulo(falso);
+    }
+    expr_nao_constante(TIPO_INTEIRO);
+}
+
+// Dobra 'esquerda op ultima_expr' (&& ou ||) quando os dois operandos são constantes: o
+// desvio gerado entre eles é descartado junto
+static bool dobra_logica(int op, const EXPR_CONSTANTE *esquerda) {
+    EXPR_CONSTANTE resultado;
+    if (!esquerda->constante || !ultima_expr.constante || !avalia_binaria(op, esquerda, &ultima_expr, &resultado)) return false;
+    gera_constante_dobrada(esquerda->inicio, &resultado);
+    return true;
+}
+
+// Uma expressão em forma de desvio vira o seu valor: empilha 1 ou 0
+static void materializa() {
+    if (ultimo_falso < 0) return;
+    int falso = ultimo_falso, fim = novo_rotulo();
+    gera_int(OP_PUSH_INT, 1);
+    gera_desvio(OP_GOTO, fim);
+    gera_rotulo(falso);
+    gera_int(OP_PUSH_INT, 0);
+    gera_rotulo(fim);
+    expr_nao_constante(TIPO_INTEIRO);
+}
+
+// Condição de if/while: o código desvia para o rótulo retornado quando ela é falsa
+static int gera_condicao() {
+    Expr();
+    return para_desvio();
+}
+
+// Valor de 'return', convertido para o tipo da função
+static void gera_retorno() {
+    if (tipo_funcao == NA_TIPO) error("Funcao void retornando um valor.");
+    Expr();
+    materializa();
+    exige_numero();
+    converte_para(tipo_de(tipo_funcao));
+}
+
+// Argumento 'i' de uma chamada da função que está na posição 'funcao' da tabela, convertido
+// para o tipo do parâmetro (os parâmetros vêm logo depois da função na tabela)
+static void gera_argumento(int funcao, int i) {
+    int pos = funcao + 1 + i;
+    Expr();
+    materializa();
+    if (pos >= tabela.topo || tabela.tokensTab[pos].idcategoria != PROC_PAR) error("Argumentos demais na chamada de funcao.");
+    if (tabela.tokensTab[pos].tamanho < 0) { // Parâmetro vetor: recebe uma string, constante ou outro parâmetro vetor
+        if (ultima_expr.tipo != TIPO_TEXTO) error("Argumento de parametro vetor nao e uma string.");
+        return;
+    }
+    exige_numero();
+    converte_para(tipo_de(tabela.tokensTab[pos].tipo));
+}
+
+// --- Atribuição ---
+// Fator registra em 'ultimo_acesso' o último acesso a variável que gerou. Se o código do lado
+// esquerdo de um '=' é exatamente esse acesso, o LOAD dá lugar ao STORE do tipo da variável.
+
+typedef struct {
+    int inicio;         // Primeira instrução do acesso (o cálculo do índice, nos vetores)
+    int fim;            // Instrução seguinte ao LOAD
+    bool indexado;      // v[i], e não a variável inteira
+    TokenInfo variavel;
+} ACESSO_VARIAVEL;
+
+static ACESSO_VARIAVEL ultimo_acesso = { .inicio = -1, .fim = -1 };
+
+// O código desde 'inicio' é exatamente o acesso registrado, até o LOAD da variável: um trecho
+// recortado ou descartado depois do registro pode ter posto outra coisa nas mesmas posições
+static bool acesso_intacto(const ACESSO_VARIAVEL *acesso, int inicio) {
+    if (acesso->inicio != inicio || acesso->fim != codigo.quantidade || acesso->fim <= inicio) return false;
+    const INSTRUCAO *load = &codigo.instrucoes[acesso->fim - 1];
+    bool global = acesso->variavel.idcategoria == VAR_GLOBAL;
+    if (acesso->indexado) return load->op == (global ? OP_LOAD_GX : OP_LOAD_LX) && load->arg.vetor.base == acesso->variavel.endereco;
+    return load->op == (global ? OP_LOAD_G : OP_LOAD_L) && load->arg.endereco == acesso->variavel.endereco;
+}
+
+// STORE que guarda na variável (ou no elemento do vetor), convertendo o valor para o tipo dela
+static OPCODE opcode_de_store(const ACESSO_VARIAVEL *acesso) {
+    bool global = acesso->variavel.idcategoria == VAR_GLOBAL;
+    if (acesso->variavel.tipo == REAL_) {
+        if (acesso->indexado) return global ? OP_FSTORE_GX : OP_FSTORE_LX;
+        return global ? OP_FSTORE_G : OP_FSTORE_L;
+    }
+    if (acesso->indexado) return global ? OP_STORE_GX : OP_STORE_LX;
+    return global ? OP_STORE_G : OP_STORE_L;
+}
+
+// O valor de uma expressão usada como comando sai da pilha; uma chamada de função void não
+// deixou valor nenhum
+static void gera_descarte() {
+    if (ultimo_falso >= 0) { // Uma expressão lógica não deixa valor: os dois caminhos se juntam aqui
+        gera_rotulo(ultimo_falso);
+        expr_nao_constante(TIPO_INTEIRO);
+        return;
+    }
+    if (ultima_expr.tipo == TIPO_NENHUM) return;
+    gera(OP_POP);
 }
 
 /**
  * @brief Ponto de entrada para a análise de qualquer expressão.
  */
 void Expr() {
-    printf("%s<Expr>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr");
     Expr_atrib();
-    diminui_ident(); printf("%s</Expr>\n", TABS);
+    FECHA_REGRA("Expr");
 }
 
 /**
  * @brief Analisa uma expressão de atribuição.
+ * Ação semântica: troca o LOAD do lado esquerdo por um STORE depois do valor. O índice de
+ * um vetor é calculado depois do valor, logo antes do STORE; se o valor da atribuição é
+ * usado (`a = b = 0`, argumentos), ele é convertido para o tipo da variável e um 'DUP' o
+ * deixa na pilha. Numa expressão usada como comando, o valor que sobra é descartado com 'POP'.
  */
 void Expr_atrib() {
-    printf("%s<Expr_atrib>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr_atrib");
+    bool valor_usado = !descarta_valor;
+    descarta_valor = false;
+    int inicio = codigo.quantidade;
     Expr_ou();
     if (t.cat == SN && t.codigo == SN_ATRIBUICAO) {
-        print_folha(t); consome(SN, SN_ATRIBUICAO);
+        ACESSO_VARIAVEL alvo = ultimo_acesso;
+        if (!acesso_intacto(&alvo, inicio)) error("Lado esquerdo da atribuicao nao e uma variavel.");
+        if (alvo.variavel.tamanho != 0 && !alvo.indexado) error("Atribuicao a um vetor inteiro.");
+
+        descarta_codigo_desde(alvo.fim - 1); // O LOAD
+        int tam_indice = 0;
+        INSTRUCAO *indice = alvo.indexado ? recorta_codigo_desde(alvo.inicio, &tam_indice) : NULL;
+
+        FOLHA(t); consome(SN, SN_ATRIBUICAO);
         Expr_atrib();
-        // A geração de código para atribuição (STOR) precisaria ser adicionada aqui
-        // e dependeria de como o endereço da variável à esquerda é tratado.
+        materializa();
+        exige_numero();
+        // O STORE já converte o que guarda: a conversão só entra se o valor da atribuição é usado
+        // (e numa constante, que é reescrita de graça)
+        if (valor_usado || ultima_expr.constante) converte_para(tipo_de(alvo.variavel.tipo));
+
+        if (valor_usado) gera(OP_DUP);
+        if (alvo.indexado) {
+            gera_trecho(indice, tam_indice);
+            free(indice);
+            gera_vetor(opcode_de_store(&alvo), alvo.variavel.endereco, alvo.variavel.tamanho);
+        } else {
+            gera_int(opcode_de_store(&alvo), alvo.variavel.endereco);
+        }
+        expr_nao_constante(tipo_de(alvo.variavel.tipo));
+    } else if (!valor_usado) {
+        gera_descarte();
     }
-    diminui_ident(); printf("%s</Expr_atrib>\n", TABS);
+    FECHA_REGRA("Expr_atrib");
 }
 
 /**
  * @brief Analisa expressões com o operador OU (||).
+ * Ação semântica: código de desvio; se o operando da esquerda é verdadeiro,
+ * o da direita é pulado.
  */
 void Expr_ou() {
-    printf("%s<Expr_ou>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr_ou");
+    int inicio = codigo.quantidade;
     Expr_e();
     while (t.cat == SN && t.codigo == SN_OR) {
-        print_folha(t); consome(SN, SN_OR);
+        EXPR_CONSTANTE esquerda = ultima_expr;
+        int verdadeiro = novo_rotulo();
+        para_desvio();
+        inverte_desvio(inicio, verdadeiro);
+        FOLHA(t); consome(SN, SN_OR);
         Expr_e();
-        // Ação semântica para '||'
+        if (!dobra_logica(SN_OR, &esquerda)) {
+            para_desvio(); // O falso da direita é o falso de tudo
+            gera_rotulo(verdadeiro);
+        }
     }
-    diminui_ident(); printf("%s</Expr_ou>\n", TABS);
+    FECHA_REGRA("Expr_ou");
 }
 
 /**
  * @brief Analisa expressões com o operador E (&&).
+ * Ação semântica: código de desvio; se o operando da esquerda é falso,
+ * o da direita é pulado.
  */
 void Expr_e() {
-    printf("%s<Expr_e>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr_e");
     Expr_relacional();
     while (t.cat == SN && t.codigo == SN_AND) {
-        print_folha(t); consome(SN, SN_AND);
+        EXPR_CONSTANTE esquerda = ultima_expr;
+        int falso = para_desvio();
+        FOLHA(t); consome(SN, SN_AND);
+        int inicio_direita = codigo.quantidade;
         Expr_relacional();
-        // Ação semântica para '&&'
+        if (!dobra_logica(SN_AND, &esquerda)) {
+            redireciona(inicio_direita, para_desvio(), falso); // Os dois falsos vão para o mesmo lugar
+            ultimo_falso = falso;
+        }
     }
-    diminui_ident(); printf("%s</Expr_e>\n", TABS);
+    FECHA_REGRA("Expr_e");
 }
 
 /**
  * @brief Analisa expressões com operadores relacionais (==, !=, <, >, etc.).
  */
 void Expr_relacional() {
-    printf("%s<Expr_relacional>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr_relacional");
     Expr_aditiva();
     if (t.cat == SN && (t.codigo == SN_COMPARACAO || t.codigo == SN_DIFERENTE || t.codigo == SN_MAIOR || t.codigo == SN_MENOR || t.codigo == SN_MAIOR_IGUAL || t.codigo == SN_MENOR_IGUAL)) {
         int op = t.codigo;
-        print_folha(t); consome(SN, t.codigo);
+        materializa();
+        exige_numero();
+        EXPR_CONSTANTE esquerda = ultima_expr;
+        int meio = codigo.quantidade;
+        FOLHA(t); consome(SN, t.codigo);
         Expr_aditiva();
-        // Ação semântica para operadores relacionais (ex: SUB, seguido de teste)
+        gera_operador_binario(op, &esquerda, meio);
     }
-    diminui_ident(); printf("%s</Expr_relacional>\n", TABS);
+    FECHA_REGRA("Expr_relacional");
 }
 
 /**
  * @brief Analisa expressões com operadores de adição e subtração (+, -).
- * Ação semântica: gera código 'ADD' ou 'SUB' após processar os dois operandos.
+ * Ação semântica: gera código 'IADD'/'ISUB' ou 'FADD'/'FSUB' após processar os dois operandos
+ * (ou um único 'PUSH' do resultado, se os dois são constantes).
  */
 void Expr_aditiva() {
-    printf("%s<Expr_aditiva>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr_aditiva");
     Expr_multiplicativa(); 
     while (t.cat == SN && (t.codigo == SN_SOMA || t.codigo == SN_SUBTRACAO)) {
         int op = t.codigo;
-        print_folha(t); consome(SN, t.codigo);
+        materializa();
+        exige_numero();
+        EXPR_CONSTANTE esquerda = ultima_expr;
+        int meio = codigo.quantidade;
+        FOLHA(t); consome(SN, t.codigo);
         Expr_multiplicativa();
-
-        if (op == SN_SOMA) {
-            gera("ADD");
-        } else {
-            gera("SUB");
-        }
+        gera_operador_binario(op, &esquerda, meio);
     }
-    diminui_ident(); printf("%s</Expr_aditiva>\n", TABS);
+    FECHA_REGRA("Expr_aditiva");
 }
 
 /**
  * @brief Analisa expressões com operadores de multiplicação e divisão (*, /).
- * Ação semântica: gera código 'MUL' ou 'DIV' após processar os dois operandos.
+ * Ação semântica: gera código 'IMUL'/'IDIV' ou 'FMUL'/'FDIV' após processar os dois operandos
+ * (ou um único 'PUSH' do resultado, se os dois são constantes).
  */
 void Expr_multiplicativa() {
-    printf("%s<Expr_multiplicativa>\n", TABS); aumenta_ident();
+    ABRE_REGRA("Expr_multiplicativa");
     Fator();
     while (t.cat == SN && (t.codigo == SN_MULTIPLICACAO || t.codigo == SN_DIVISAO)) {
         int op = t.codigo;
-        print_folha(t); consome(SN, t.codigo);
+        materializa();
+        exige_numero();
+        EXPR_CONSTANTE esquerda = ultima_expr;
+        int meio = codigo.quantidade;
+        FOLHA(t); consome(SN, t.codigo);
         Fator(); 
-
-        if (op == SN_MULTIPLICACAO) {
-            gera("MUL");
-        } else {
-            gera("DIV");
-        }
+        gera_operador_binario(op, &esquerda, meio);
     }
-    diminui_ident(); printf("%s</Expr_multiplicativa>\n", TABS);
+    FECHA_REGRA("Expr_multiplicativa");
 }
 
 /**
@@ -577,70 +1064,123 @@ void Expr_multiplicativa() {
  * e 'CALL' para funções.
  */
 void Fator() {
-    printf("%s<Fator>\n", TABS); aumenta_ident();
-    char linha[100];
+    ABRE_REGRA("Fator");
+    bool acesso = false; // Só um acesso a variável fica registrado para um '=' que venha depois
 
     if (t.cat == SN && (t.codigo == SN_SOMA || t.codigo == SN_SUBTRACAO || t.codigo == SN_NEGACAO)) {
-        print_folha(t); consome(SN, t.codigo);
+        int op = t.codigo;
+        FOLHA(t); consome(SN, t.codigo);
+        int inicio = codigo.quantidade;
         Fator();
-        // Adicionar geração de código para negação unária se necessário
+        // '+x' não gera nada; '-x' e '!x' são dobrados quando x é constante, e '!' só troca
+        // o sentido dos desvios de uma expressão lógica
+        if (op == SN_SOMA) {
+            exige_numero();
+        } else if (op == SN_SUBTRACAO) {
+            materializa();
+            exige_numero();
+            if (!ultima_expr.constante) {
+                gera(ultima_expr.tipo == TIPO_REAL ? OP_FNEG : OP_INEG);
+            } else {
+                EXPR_CONSTANTE resultado = ultima_expr;
+                if (resultado.tipo == TIPO_REAL) resultado.valor_real = -resultado.valor_real;
+                else resultado.inteiro = (int)(0u - (unsigned)resultado.inteiro);
+                gera_constante_dobrada(ultima_expr.inicio, &resultado);
+            }
+        } else if (op == SN_NEGACAO) {
+            if (ultimo_falso >= 0) {
+                int falso = novo_rotulo();
+                inverte_desvio(inicio, falso);
+                ultimo_falso = falso;
+            } else if (!ultima_expr.constante) {
+                exige_valor();
+                gera(OP_NOT);
+                ultima_expr.tipo = TIPO_INTEIRO;
+            } else {
+                EXPR_CONSTANTE resultado = { true, TIPO_INTEIRO, ultima_expr.inicio, !verdadeira(&ultima_expr), 0, false };
+                gera_constante_dobrada(ultima_expr.inicio, &resultado);
+            }
+        }
     } else if (t.cat == ID) {
-        char id_lexema[100];
-        strcpy(id_lexema, t.lexema); // Salva o nome do identificador
-        print_folha(t); consome(ID, 0);
+        int id_nome = t.nome; // Salva o código do nome do identificador
+        FOLHA(t); consome(ID, 0);
 
         if (t.cat == SN && t.codigo == ABRE_PARENTESES) { // Chamada de função
-            print_folha(t); consome(SN, ABRE_PARENTESES);
+            // Os tipos dos parâmetros e do retorno vêm da declaração, que tem de vir antes
+            int funcao = buscaLexPos(id_nome);
+            if (funcao < 0) error("Funcao chamada antes de ser declarada.");
+            if (tabela.tokensTab[funcao].idcategoria != PROC && tabela.tokensTab[funcao].idcategoria != PROT_) error("Variavel usada como funcao.");
+            TIPO tipo_retorno = tabela.tokensTab[funcao].tipo;
+            int num_args = 0;
+
+            FOLHA(t); consome(SN, ABRE_PARENTESES);
             if (!(t.cat == SN && t.codigo == FECHA_PARENTESES)) {
-                Expr(); // Gera código para o primeiro argumento
+                gera_argumento(funcao, num_args++); // Gera código para o primeiro argumento
                 while (t.cat == SN && t.codigo == VIRGULA) {
-                    print_folha(t); consome(SN, VIRGULA);
-                    Expr(); // Gera código para os argumentos subsequentes
+                    FOLHA(t); consome(SN, VIRGULA);
+                    gera_argumento(funcao, num_args++); // Gera código para os argumentos subsequentes
                 }
             }
-            print_folha(t); consome(SN, FECHA_PARENTESES);
+            int proximo = funcao + 1 + num_args;
+            if (proximo < tabela.topo && tabela.tokensTab[proximo].idcategoria == PROC_PAR) error("Argumentos de menos na chamada de funcao.");
+            FOLHA(t); consome(SN, FECHA_PARENTESES);
             
             // Gera a instrução de chamada de procedimento
             // Assumindo que o rótulo da função é o próprio nome
-            sprintf(linha, "CALL %s", id_lexema);
-            gera(linha);
+            gera_nome(OP_CALL, id_nome);
+            expr_nao_constante(tipo_de(tipo_retorno));
 
         } else { // Variável ou vetor
-            if (t.cat == SN && t.codigo == ABRE_COLCHETES) { // Acesso a vetor
-                print_folha(t); consome(SN, ABRE_COLCHETES);
+            // O endereço vem da declaração: índice no segmento de dados (global) ou slot no quadro
+            int inicio = codigo.quantidade;
+            TokenInfo variavel = buscaDecl(id_nome);
+            if (variavel.idcategoria == PROC || variavel.idcategoria == PROT_) error("Funcao usada como variavel.");
+            bool global = variavel.idcategoria == VAR_GLOBAL;
+            bool indexado = t.cat == SN && t.codigo == ABRE_COLCHETES;
+
+            if (indexado) { // Acesso a vetor
+                if (variavel.tamanho == 0) error("Indice aplicado a uma variavel que nao e vetor.");
+                // O parâmetro vetor carrega uma string, não as células de um vetor
+                if (variavel.tamanho < 0) error("Vetor recebido como parametro nao pode ser indexado.");
+                FOLHA(t); consome(SN, ABRE_COLCHETES);
                 Expr(); // Gera código para a expressão do índice
-                print_folha(t); consome(SN, FECHA_COLCHETES);
-                // Geração de código para acesso a vetor (ex: ADD para calcular offset)
-                // seria necessária aqui.
+                materializa();
+                exige_numero();
+                if (ultima_expr.tipo != TIPO_INTEIRO) error("Indice de vetor nao e inteiro.");
+                FOLHA(t); consome(SN, FECHA_COLCHETES);
+                gera_vetor(global ? OP_LOAD_GX : OP_LOAD_LX, variavel.endereco, variavel.tamanho);
+            } else {
+                // Um vetor não é passado nem lido inteiro: o LOAD da base só traria o elemento 0
+                if (variavel.tamanho > 0) error("Vetor usado sem indice.");
+                gera_int(global ? OP_LOAD_G : OP_LOAD_L, variavel.endereco);
             }
-            
-            // Gera instrução para carregar o valor da variável na pilha.
-            // Usando PUSH como substituto para LOAD m,n para simplicidade.
-            sprintf(linha, "PUSH %s", id_lexema);
-            gera(linha);
+            ultimo_acesso = (ACESSO_VARIAVEL){ inicio, codigo.quantidade, indexado, variavel };
+            acesso = true;
+            expr_nao_constante(!indexado && variavel.tamanho < 0 ? TIPO_TEXTO : tipo_de(variavel.tipo));
         }
     } else if (t.cat == CT_INT) {
-        sprintf(linha, "PUSH %d", t.valInt);
-        gera(linha);
-        print_folha(t); consome(t.cat, 0);
+        expr_constante_inteira(codigo.quantidade, t.valInt);
+        gera_int(OP_PUSH_INT, t.valInt);
+        FOLHA(t); consome(t.cat, 0);
     } else if (t.cat == CT_REAL) {
-        sprintf(linha, "PUSH %f", t.valReal);
-        gera(linha);
-        print_folha(t); consome(t.cat, 0);
+        expr_constante_real(codigo.quantidade, t.valReal);
+        gera_real(t.valReal);
+        FOLHA(t); consome(t.cat, 0);
     } else if (t.cat == CT_CHAR) {
-        sprintf(linha, "PUSH '%c'", t.valInt);
-        gera(linha);
-        print_folha(t); consome(t.cat, 0);
+        expr_constante_inteira(codigo.quantidade, t.valInt);
+        gera_int(OP_PUSH_CHAR, t.valInt);
+        FOLHA(t); consome(t.cat, 0);
     } else if (t.cat == CT_STRING) {
-        sprintf(linha, "PUSH \"%s\"", t.lexema);
-        gera(linha);
-        print_folha(t); consome(t.cat, 0);
+        gera_string(t.nome);
+        expr_nao_constante(TIPO_TEXTO);
+        FOLHA(t); consome(t.cat, 0);
     } else if (t.cat == SN && t.codigo == ABRE_PARENTESES) {
-        print_folha(t); consome(SN, ABRE_PARENTESES);
+        FOLHA(t); consome(SN, ABRE_PARENTESES);
         Expr();
-        print_folha(t); consome(SN, FECHA_PARENTESES);
+        FOLHA(t); consome(SN, FECHA_PARENTESES);
     } else {
         error("Fator mal formado. Esperado ID, constante ou '('");
     }
-    diminui_ident(); printf("%s</Fator>\n", TABS);
+    if (!acesso) ultimo_acesso.fim = -1; // Nem '+a' nem '(a)' são uma variável
+    FECHA_REGRA("Fator");
 }
\ No newline at end of file
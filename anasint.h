@@ -8,13 +8,15 @@
 // --- Variáveis Globais ---
 extern TOKEN t;       // Token atual, lido pelo Analex
 extern FILE *fd;      // Ponteiro para o arquivo de código fonte
-extern char TABS[200]; // Declara que a variável TABS existe em outro arquivo
 
 // --- Funções do Analisador Sintático (baseadas na gramática) ---
 
 // Função inicial que começa a análise
 void Prog();
 
+// Faz o Prog ler de um fluxo pré-analisado (ver pre_analex) em vez de chamar o Analex a cada token
+void usar_fluxo_de_tokens(FLUXO_TOKENS *fluxo);
+
 // Funções para declarações
 void Decl();
 void Decl_var();
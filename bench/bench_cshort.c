@@ -0,0 +1,251 @@
+/*
+    Benchmark do front end: mede, para cada arquivo, o Analex sozinho, a pré-análise para o
+    fluxo de tokens, o Prog() de ponta a ponta e a emissão do código gerado.
+
+    Uso: bench_cshort [-n repeticoes] [-o resultados.csv] [--threads N] [--rastro NIVEL] arquivo...
+        -n          quantas vezes cada fase é repetida; vale o menor tempo (padrão: 3)
+        -o          arquivo CSV onde uma linha por fase é acrescentada (padrão: bench/resultados.csv)
+        --threads   threads da fase pre_analex (padrão: 1, a leitura serial)
+        --rastro    nível do rastro durante o Prog: desligado (padrão), tokens ou arvore
+
+    Durante o Prog e a emissão, a saída padrão e a de erro vão para /dev/null: o rastro, se
+    ligado, continua sendo impresso (faz parte do custo medido), só não aparece.
+    O pico de RSS é o do processo inteiro até o fim de cada fase (getrusage).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "analex.h"
+#include "anasint.h"
+#include "tabela_simbolos.h"
+#include "gerador_codigo.h"
+#include "rastro.h"
+
+// --- Variáveis Globais (as mesmas que main.c define) ---
+TOKEN t;
+FILE *fd;
+int contLinha = 1;
+
+/* Resultado de uma fase para um arquivo */
+typedef struct
+{
+    const char *fase;
+    double segundos;    // Menor tempo entre as repetições
+    long tokens;
+    int linhas;
+    long pico_rss_kb;
+} MEDIDA;
+
+static double agora()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long pico_rss_kb()
+{
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_maxrss; // Em KB no Linux
+}
+
+/* Manda stdout e stderr para /dev/null; restaura_saida desfaz */
+static int saida_salva = -1, erro_salvo = -1;
+
+static void silencia_saida()
+{
+    fflush(stdout);
+    fflush(stderr);
+    saida_salva = dup(STDOUT_FILENO);
+    erro_salvo = dup(STDERR_FILENO);
+    int nulo = open("/dev/null", O_WRONLY);
+    dup2(nulo, STDOUT_FILENO);
+    dup2(nulo, STDERR_FILENO);
+    close(nulo);
+}
+
+static void restaura_saida()
+{
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saida_salva, STDOUT_FILENO);
+    dup2(erro_salvo, STDERR_FILENO);
+    close(saida_salva);
+    close(erro_salvo);
+}
+
+/* Deixa o compilador no estado de um processo novo e abre o arquivo com a fonte em memória */
+static void prepara(const char *arquivo)
+{
+    if ((fd = fopen(arquivo, "r")) == NULL)
+    {
+        fprintf(stderr, "Erro: Arquivo de entrada '%s' nao encontrado.\n", arquivo);
+        exit(1);
+    }
+    carregar_fonte(fd);
+    contLinha = 1;
+    usar_fluxo_de_tokens(NULL);
+    limparTabela();
+    limpar_codigo();
+}
+
+static void encerra()
+{
+    liberar_fonte();
+    liberar_nomes();
+    fclose(fd);
+}
+
+/* Só o Analex, token a token, até o fim do arquivo */
+static void mede_analex(const char *arquivo, MEDIDA *m)
+{
+    prepara(arquivo);
+    double inicio = agora();
+    long tokens = 0;
+    TOKEN tk;
+    do
+    {
+        tk = Analex(fd);
+        tokens++;
+    } while (tk.cat != FIM_ARQ);
+    double tempo = agora() - inicio;
+
+    if (m->segundos == 0 || tempo < m->segundos) m->segundos = tempo;
+    m->tokens = tokens;
+    m->linhas = contLinha;
+    encerra();
+}
+
+/* O arquivo inteiro para um FLUXO_TOKENS (serial ou com threads) */
+static void mede_pre_analex(const char *arquivo, int num_threads, MEDIDA *m)
+{
+    FLUXO_TOKENS fluxo;
+    prepara(arquivo);
+    double inicio = agora();
+    if (!pre_analex_paralelo(fd, &fluxo, num_threads))
+    {
+        fprintf(stderr, "Erro: pre_analex falhou em '%s'.\n", arquivo);
+        exit(1);
+    }
+    double tempo = agora() - inicio;
+
+    if (m->segundos == 0 || tempo < m->segundos) m->segundos = tempo;
+    m->tokens = fluxo.quantidade;
+    m->linhas = contLinha;
+    liberar_fluxo(&fluxo);
+    encerra();
+}
+
+static NIVEL_RASTRO nivel_prog = RASTRO_DESLIGADO; // Nível do rastro durante o Prog (--rastro)
+
+/* Prog() de ponta a ponta (Analex sob demanda + parser + tabela de símbolos + geração), seguido da emissão */
+static void mede_prog_e_emissao(const char *arquivo, MEDIDA *prog, MEDIDA *emissao)
+{
+    prepara(arquivo);
+    silencia_saida();
+    abrir_rastro(nivel_prog, NULL, 0);
+    double inicio = agora();
+    Prog();
+    double meio = agora();
+    fechar_rastro();
+    salvar_codigo_em_arquivo("/dev/null");
+    double fim = agora();
+    restaura_saida();
+
+    if (prog->segundos == 0 || meio - inicio < prog->segundos) prog->segundos = meio - inicio;
+    if (emissao->segundos == 0 || fim - meio < emissao->segundos) emissao->segundos = fim - meio;
+    prog->linhas = emissao->linhas = contLinha;
+    encerra();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *resultados = "bench/resultados.csv";
+    int repeticoes = 3;
+    int num_threads = 1;
+    int primeiro_arquivo = argc;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) repeticoes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) resultados = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) num_threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rastro") == 0 && i + 1 < argc)
+        {
+            const char *nome = argv[++i];
+            nivel_prog = strcmp(nome, "arvore") == 0 ? RASTRO_ARVORE : strcmp(nome, "tokens") == 0 ? RASTRO_TOKENS : RASTRO_DESLIGADO;
+        }
+        else
+        {
+            primeiro_arquivo = i;
+            break;
+        }
+    }
+    if (primeiro_arquivo == argc || repeticoes < 1)
+    {
+        fprintf(stderr, "Uso: bench_cshort [-n repeticoes] [-o resultados.csv] [--threads N] [--rastro NIVEL] arquivo...\n");
+        return 1;
+    }
+
+    struct stat st;
+    bool novo = stat(resultados, &st) != 0 || st.st_size == 0;
+    FILE *csv = fopen(resultados, "a");
+    if (csv == NULL)
+    {
+        fprintf(stderr, "Erro: nao foi possivel abrir '%s'.\n", resultados);
+        return 1;
+    }
+    if (novo) fprintf(csv, "data,arquivo,bytes,fase,threads,segundos,tokens,linhas,tokens_por_s,linhas_por_s,mb_por_s,pico_rss_kb\n");
+
+    char data[32];
+    time_t agora_t = time(NULL);
+    strftime(data, sizeof(data), "%Y-%m-%dT%H:%M:%S", localtime(&agora_t));
+
+    printf("%-32s %-11s %9s %10s %9s %12s %11s %8s %10s\n", "arquivo", "fase", "segundos", "tokens", "linhas", "tokens/s", "linhas/s", "MB/s", "RSS (KB)");
+
+    for (int a = primeiro_arquivo; a < argc; a++)
+    {
+        const char *arquivo = argv[a];
+        if (stat(arquivo, &st) != 0)
+        {
+            fprintf(stderr, "Erro: Arquivo de entrada '%s' nao encontrado.\n", arquivo);
+            return 1;
+        }
+        long bytes = (long)st.st_size;
+
+        MEDIDA medidas[4] = { { .fase = "analex" }, { .fase = "pre_analex" }, { .fase = "prog" }, { .fase = "emissao" } };
+
+        // Se o Prog encontrar um erro, o programa termina com a saída silenciada: este aviso diz onde parou
+        fprintf(stderr, "medindo %s...\n", arquivo);
+        for (int r = 0; r < repeticoes; r++) mede_analex(arquivo, &medidas[0]);
+        medidas[0].pico_rss_kb = pico_rss_kb();
+        for (int r = 0; r < repeticoes; r++) mede_pre_analex(arquivo, num_threads, &medidas[1]);
+        medidas[1].pico_rss_kb = pico_rss_kb();
+        for (int r = 0; r < repeticoes; r++) mede_prog_e_emissao(arquivo, &medidas[2], &medidas[3]);
+        medidas[2].pico_rss_kb = medidas[3].pico_rss_kb = pico_rss_kb();
+        medidas[2].tokens = medidas[3].tokens = medidas[0].tokens;
+
+        for (int f = 0; f < 4; f++)
+        {
+            MEDIDA *m = &medidas[f];
+            double s = m->segundos > 0 ? m->segundos : 1e-9;
+            printf("%-32s %-11s %9.4f %10ld %9d %12.0f %11.0f %8.1f %10ld\n", arquivo, m->fase, m->segundos, m->tokens, m->linhas,
+                   m->tokens / s, m->linhas / s, bytes / s / (1024.0 * 1024.0), m->pico_rss_kb);
+            fprintf(csv, "%s,%s,%ld,%s,%d,%.6f,%ld,%d,%.0f,%.0f,%.2f,%ld\n", data, arquivo, bytes, m->fase, f == 1 ? num_threads : 1,
+                    m->segundos, m->tokens, m->linhas, m->tokens / s, m->linhas / s, bytes / s / (1024.0 * 1024.0), m->pico_rss_kb);
+        }
+        fflush(stdout);
+    }
+
+    fclose(csv);
+    printf("Resultados acrescentados em: %s\n", resultados);
+    return 0;
+}
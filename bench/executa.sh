@@ -0,0 +1,18 @@
+# Gera programas CShort sintéticos de todas as formas e mede o front end em cada um.
+# Uso: sh bench/executa.sh [tamanho_em_bytes] [repeticoes] [threads]
+# Os resultados são acrescentados em bench/resultados.csv, para comparar execuções ao longo do tempo.
+TAMANHO=${1:-1048576}
+REPETICOES=${2:-3}
+THREADS=${3:-1}
+
+cd "$(dirname "$0")/.." || exit 1
+gcc gera_afd.c -o gera_afd && ./gera_afd AFD/afd.jff afd_tabela.h || exit 1
+gcc -O2 bench/gera_cshort.c -o bench/gera_cshort || exit 1
+gcc -O2 -I. bench/bench_cshort.c analex.c anasint.c tabela_simbolos.c tabela_nomes.c gerador_codigo.c rastro.c bytecode.c interpretador.c otimizador.c -o bench/bench_cshort -pthread || exit 1
+
+mkdir -p bench/entradas
+for FORMA in misto globais aninhado expressoes comentarios funcoes; do
+    bench/gera_cshort --forma $FORMA --tamanho $TAMANHO bench/entradas/$FORMA.txt || exit 1
+done
+
+bench/bench_cshort -n $REPETICOES --threads $THREADS -o bench/resultados.csv bench/entradas/*.txt
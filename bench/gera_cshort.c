@@ -0,0 +1,346 @@
+/*
+    Gerador de programas CShort sintéticos para o benchmark do front end.
+
+    Uso: gera_cshort [--forma F] [--tamanho BYTES] [--semente S] [--max-simbolos N] saida.txt
+        --forma        misto (padrão), globais, aninhado, expressoes, comentarios ou funcoes
+        --tamanho      tamanho aproximado do arquivo gerado (padrão: 1048576)
+        --semente      semente do gerador pseudoaleatório (padrão: 1), para repetir a mesma entrada
+        --max-simbolos quantos símbolos (globais + funções + parâmetros) o programa declara no
+                       máximo (padrão: 1000); só limita o formato da entrada, já que a tabela de
+                       símbolos do compilador cresce sob demanda
+
+    Os programas são sempre aceitos pelo parser: globais, funções, parâmetros e locais usam
+    prefixos diferentes (g, f, p, l), então nunca há redeclaração, as funções só chamam
+    funções já declaradas e os vetores globais sempre aparecem com um índice constante. Quando o limite de símbolos acaba, o restante do tamanho pedido
+    vai para o corpo de uma última função 'main'.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+/* Parâmetros de forma do programa gerado */
+typedef struct
+{
+    const char *nome;
+    int globais;            // Variáveis globais declaradas no início
+    int comandos;           // Comandos por função
+    int profundidade;       // Profundidade máxima de if/while/blocos aninhados
+    int operandos;          // Operandos por expressão (no máximo)
+    int linhas_comentario;  // Linhas de comentário antes de cada função (e chance de comentário entre comandos)
+    int params;             // Parâmetros por função (no máximo)
+} FORMA;
+
+static const FORMA formas[] =
+{
+    { "misto",       50, 25, 3,  6, 3, 3 },
+    { "globais",    700,  5, 1,  3, 0, 1 },
+    { "aninhado",    10, 12, 12, 3, 0, 2 },
+    { "expressoes",  20, 10, 1, 60, 0, 3 },
+    { "comentarios", 20, 10, 2,  4, 40, 2 },
+    { "funcoes",     10,  2, 1,  3, 0, 4 },
+};
+
+static FILE *saida;
+static long escritos = 0;
+static unsigned long long estado_aleatorio = 1;
+
+static const FORMA *forma;
+static int num_funcoes = 0;     // Funções já declaradas (f0 .. f{num_funcoes-1})
+static int params_funcao[4096]; // Quantidade de parâmetros de cada função declarada
+static int num_locais = 0;      // Locais da função atual (l0 .. l{num_locais-1})
+static int num_params = 0;      // Parâmetros da função atual
+static int *tamanho_global;     // Elementos de cada global vetor (0 = escalar)
+
+/* xorshift64*: rápido e igual em qualquer plataforma */
+static unsigned int aleatorio(unsigned int limite)
+{
+    estado_aleatorio ^= estado_aleatorio >> 12;
+    estado_aleatorio ^= estado_aleatorio << 25;
+    estado_aleatorio ^= estado_aleatorio >> 27;
+    return (unsigned int)((estado_aleatorio * 2685821657736338717ull) >> 33) % limite;
+}
+
+static void escreve(const char *formato, ...)
+{
+    va_list args;
+    va_start(args, formato);
+    int n = vfprintf(saida, formato, args);
+    va_end(args);
+    if (n > 0) escritos += n;
+}
+
+/* Uma global; um vetor vai sempre com um índice dentro dos limites */
+static void global(unsigned int g)
+{
+    if (tamanho_global[g] > 0) escreve("g%u[%u]", g, aleatorio(tamanho_global[g]));
+    else escreve("g%u", g);
+}
+
+static void indenta(int nivel)
+{
+    for (int i = 0; i < nivel; i++) escreve("    ");
+}
+
+/* Um operando: variável local, parâmetro, global, constante (nunca zero) ou chamada de função já declarada */
+static void operando(int nivel_expr);
+
+static void expressao(int operandos, int nivel_expr)
+{
+    static const char *ops[] = { "+", "-", "*", "/" };
+    int n = 1 + aleatorio(operandos);
+    for (int i = 0; i < n; i++)
+    {
+        if (i > 0) escreve(" %s ", ops[aleatorio(4)]);
+        if (nivel_expr < 3 && n > 2 && aleatorio(8) == 0)
+        {
+            escreve("(");
+            expressao(operandos / 2 + 1, nivel_expr + 1);
+            escreve(")");
+        }
+        else
+        {
+            operando(nivel_expr);
+        }
+    }
+}
+
+static void operando(int nivel_expr)
+{
+    switch (aleatorio(7))
+    {
+        case 0:
+        case 1:
+            if (num_locais > 0) { escreve("l%u", aleatorio(num_locais)); break; }
+            /* fallthrough */
+        case 2:
+            if (num_params > 0) { escreve("p%u", aleatorio(num_params)); break; }
+            /* fallthrough */
+        case 3:
+            if (forma->globais > 0) { global(aleatorio(forma->globais)); break; }
+            /* fallthrough */
+        case 4:
+            escreve("%u", 1 + aleatorio(100000));
+            break;
+        case 5:
+            escreve("%u.%u", aleatorio(1000), 1 + aleatorio(99999));
+            break;
+        default:
+            if (num_funcoes > 0 && nivel_expr < 2)
+            {
+                int f = aleatorio(num_funcoes);
+                escreve("f%d(", f);
+                for (int i = 0; i < params_funcao[f]; i++)
+                {
+                    if (i > 0) escreve(", ");
+                    expressao(2, nivel_expr + 1);
+                }
+                escreve(")");
+            }
+            else
+            {
+                escreve("%u", 1 + aleatorio(1000));
+            }
+            break;
+    }
+}
+
+static void condicao()
+{
+    static const char *rel[] = { "==", "!=", "<", ">", "<=", ">=" };
+    static const char *log[] = { "&&", "||" };
+    int n = 1 + aleatorio(3);
+    for (int i = 0; i < n; i++)
+    {
+        if (i > 0) escreve(" %s ", log[aleatorio(2)]);
+        if (aleatorio(6) == 0) escreve("!");
+        escreve("(");
+        expressao(forma->operandos / 2 + 1, 1);
+        escreve(" %s ", rel[aleatorio(6)]);
+        expressao(forma->operandos / 2 + 1, 1);
+        escreve(")");
+    }
+}
+
+static void comentario(int nivel, int linhas)
+{
+    indenta(nivel);
+    escreve("/*");
+    for (int i = 0; i < linhas; i++)
+    {
+        escreve(" Linha %d de comentario: descreve o trecho seguinte, com \"aspas\", *asteriscos* e codigo x = y + 1;\n", i);
+        if (i + 1 < linhas) indenta(nivel);
+    }
+    if (linhas == 0) escreve(" comentario curto ");
+    escreve("*/\n");
+}
+
+static void atribuicao(int nivel)
+{
+    indenta(nivel);
+    if (num_locais > 0) escreve("l%u", aleatorio(num_locais));
+    else global(aleatorio(forma->globais > 0 ? forma->globais : 1));
+    escreve(" = ");
+    expressao(forma->operandos, 0);
+    escreve(";\n");
+}
+
+static void comando(int nivel, int profundidade)
+{
+    if (forma->linhas_comentario > 0 && aleatorio(4) == 0) comentario(nivel, aleatorio(forma->linhas_comentario / 4 + 1));
+
+    int escolha = profundidade < forma->profundidade ? aleatorio(6) : 0;
+    switch (escolha)
+    {
+        case 1:
+            indenta(nivel); escreve("if ("); condicao(); escreve(") {\n");
+            comando(nivel + 1, profundidade + 1);
+            if (aleatorio(2)) comando(nivel + 1, profundidade + 1);
+            indenta(nivel); escreve("}\n");
+            if (aleatorio(2))
+            {
+                indenta(nivel); escreve("else {\n");
+                comando(nivel + 1, profundidade + 1);
+                indenta(nivel); escreve("}\n");
+            }
+            break;
+        case 2:
+            indenta(nivel); escreve("while ("); condicao(); escreve(") {\n");
+            comando(nivel + 1, profundidade + 1);
+            atribuicao(nivel + 1);
+            indenta(nivel); escreve("}\n");
+            break;
+        case 3:
+            indenta(nivel); escreve("{\n");
+            comando(nivel + 1, profundidade + 1);
+            comando(nivel + 1, profundidade + 1);
+            indenta(nivel); escreve("}\n");
+            break;
+        case 4:
+            if (num_funcoes > 0)
+            {
+                int f = aleatorio(num_funcoes);
+                indenta(nivel); escreve("f%d(", f);
+                for (int i = 0; i < params_funcao[f]; i++)
+                {
+                    if (i > 0) escreve(", ");
+                    expressao(forma->operandos / 2 + 1, 1);
+                }
+                escreve(");\n");
+                break;
+            }
+            /* fallthrough */
+        default:
+            atribuicao(nivel);
+            break;
+    }
+}
+
+static const char *tipos[] = { "int", "float", "char", "bool" };
+
+/* Gera uma função; com 'alvo' > 0, continua gerando comandos até o arquivo chegar a esse tamanho */
+static void funcao(const char *nome, int params, long alvo)
+{
+    if (forma->linhas_comentario > 0) comentario(0, forma->linhas_comentario);
+
+    bool e_main = strcmp(nome, "main") == 0;
+    escreve("%s %s(", e_main ? "void" : "int", nome);
+    num_params = params;
+    if (params == 0) escreve("void");
+    for (int i = 0; i < params; i++) escreve("%s%s p%d", i > 0 ? ", " : "", tipos[aleatorio(4)], i);
+    escreve(")\n{\n");
+
+    num_locais = 2 + aleatorio(6);
+    for (int i = 0; i < num_locais; i++)
+    {
+        if (i % 3 == 0) escreve("%s    %s l%d", i > 0 ? ";\n" : "", tipos[aleatorio(2)], i);
+        else escreve(", l%d", i);
+    }
+    escreve(";\n");
+
+    for (int i = 0; i < forma->comandos || (alvo > 0 && escritos < alvo); i++) comando(1, 0);
+    if (!e_main)
+    {
+        escreve("    return ");
+        expressao(forma->operandos, 0);
+        escreve(";\n");
+    }
+    escreve("}\n\n");
+    num_locais = 0;
+    num_params = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *nome_forma = "misto";
+    const char *arquivo = NULL;
+    long tamanho = 1024 * 1024;
+    int max_simbolos = 1000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--forma") == 0 && i + 1 < argc) nome_forma = argv[++i];
+        else if (strcmp(argv[i], "--tamanho") == 0 && i + 1 < argc) tamanho = atol(argv[++i]);
+        else if (strcmp(argv[i], "--semente") == 0 && i + 1 < argc) estado_aleatorio = strtoull(argv[++i], NULL, 10) | 1;
+        else if (strcmp(argv[i], "--max-simbolos") == 0 && i + 1 < argc) max_simbolos = atoi(argv[++i]);
+        else arquivo = argv[i];
+    }
+
+    for (size_t i = 0; i < sizeof(formas) / sizeof(formas[0]); i++)
+    {
+        if (strcmp(formas[i].nome, nome_forma) == 0) forma = &formas[i];
+    }
+    if (forma == NULL || arquivo == NULL)
+    {
+        fprintf(stderr, "Uso: gera_cshort [--forma misto|globais|aninhado|expressoes|comentarios|funcoes] [--tamanho BYTES] [--semente S] [--max-simbolos N] saida.txt\n");
+        return 1;
+    }
+    if ((saida = fopen(arquivo, "w")) == NULL)
+    {
+        fprintf(stderr, "Erro: nao foi possivel criar '%s'.\n", arquivo);
+        return 1;
+    }
+
+    // Globais, alguns vetores, em linhas de até 8 nomes
+    int simbolos = forma->globais;
+    tamanho_global = calloc(forma->globais + 1, sizeof(int));
+    if (tamanho_global == NULL)
+    {
+        fprintf(stderr, "Erro: memoria insuficiente.\n");
+        return 1;
+    }
+    for (int i = 0; i < forma->globais; i++)
+    {
+        if (i % 8 == 0) escreve("%s%s g%d", i > 0 ? ";\n" : "", tipos[aleatorio(4)], i);
+        else if (aleatorio(10) == 0)
+        {
+            tamanho_global[i] = 1 + aleatorio(100);
+            escreve(", g%d[%d]", i, tamanho_global[i]);
+        }
+        else escreve(", g%d", i);
+    }
+    if (forma->globais > 0) escreve(";\n\n");
+
+    // Funções até chegar ao tamanho pedido ou a --max-simbolos; a 'main' fica com o resto
+    int max_funcoes = (int)(sizeof(params_funcao) / sizeof(params_funcao[0]));
+    while (escritos < tamanho)
+    {
+        int params = aleatorio(forma->params + 1);
+        if (simbolos + 1 + params + 1 > max_simbolos || num_funcoes == max_funcoes)
+        {
+            funcao("main", 0, tamanho);
+            break;
+        }
+        char nome[16];
+        snprintf(nome, sizeof(nome), "f%d", num_funcoes);
+        funcao(nome, params, 0);
+        params_funcao[num_funcoes++] = params;
+        simbolos += 1 + params;
+    }
+
+    fclose(saida);
+    free(tamanho_global);
+    return 0;
+}
@@ -0,0 +1,474 @@
+/**
+ * @file bytecode.c
+ * @brief Montagem, gravação, carga e desmontagem das imagens .csb.
+ *
+ * `montar_imagem` monta o arquivo inteiro em um único buffer (cabeçalho, seções e
+ * textos), de modo que gravar é um fwrite e a imagem montada pode ser usada em
+ * memória exatamente como uma carregada do disco.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+#include "gerador_codigo.h"
+#include "tabela_nomes.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/** Arredonda um deslocamento para o início da próxima seção. */
+static uint32_t alinha(size_t deslocamento) {
+    return (uint32_t)((deslocamento + CSB_ALINHAMENTO - 1) & ~(size_t)(CSB_ALINHAMENTO - 1));
+}
+
+static const char *imagem_invalida(const IMAGEM_CSB *imagem);
+
+/** Aponta as seções de uma imagem para dentro do seu buffer. */
+static void aponta_secoes(IMAGEM_CSB *imagem) {
+    const char *base = imagem->base;
+    const CSB_CABECALHO *cab = imagem->base;
+    imagem->cabecalho = cab;
+    imagem->instrucoes = (const CSB_INSTRUCAO *)(base + cab->off_instrucoes);
+    imagem->constantes = (const CSB_CONSTANTE *)(base + cab->off_constantes);
+    imagem->simbolos = (const CSB_SIMBOLO *)(base + cab->off_simbolos);
+    imagem->linhas = (const CSB_LINHA *)(base + cab->off_linhas);
+    imagem->textos = base + cab->off_textos;
+}
+
+bool montar_imagem(IMAGEM_CSB *imagem, bool com_linhas) {
+    memset(imagem, 0, sizeof(*imagem));
+
+    // Posição de cada rótulo (a instrução LABEL) e o símbolo de cada nome usado pelo código
+    int *posicao_rotulo = malloc(((size_t)codigo.num_rotulos + 1) * sizeof(int));
+    int num_nomes = quantidade_nomes();
+    int *simbolo_do_nome = malloc(((size_t)num_nomes + 1) * sizeof(int));
+    CSB_SIMBOLO *simbolos = malloc(((size_t)num_nomes + 1) * sizeof(CSB_SIMBOLO));
+    int *nome_do_simbolo = malloc(((size_t)num_nomes + 1) * sizeof(int));
+    if (!posicao_rotulo || !simbolo_do_nome || !simbolos || !nome_do_simbolo) {
+        free(posicao_rotulo); free(simbolo_do_nome); free(simbolos); free(nome_do_simbolo);
+        return false;
+    }
+    for (int r = 0; r < codigo.num_rotulos; r++) posicao_rotulo[r] = -1;
+    for (int n = 0; n < num_nomes; n++) simbolo_do_nome[n] = -1;
+    for (int i = 0; i < codigo.quantidade; i++) {
+        if (codigo.instrucoes[i].op == OP_LABEL) posicao_rotulo[codigo.instrucoes[i].arg.rotulo] = i;
+    }
+
+    // Os símbolos: primeiro as funções com corpo (na ordem em que foram geradas), depois os
+    // demais nomes na ordem da primeira referência
+    int num_simbolos = 0;
+    size_t tam_textos = 0;
+    for (int f = 0; f < codigo.num_funcoes; f++) {
+        const FUNCAO_GERADA *funcao = &codigo.funcoes[f];
+        simbolo_do_nome[funcao->nome] = num_simbolos;
+        nome_do_simbolo[num_simbolos] = funcao->nome;
+        simbolos[num_simbolos++] = (CSB_SIMBOLO){ 0, (uint32_t)tamanho_nome(funcao->nome), CSB_FUNCAO,
+                                                  funcao->inicio, (uint32_t)funcao->num_params, funcao->com_retorno,
+                                                  (uint32_t)funcao->tam_quadro, 0 };
+        tam_textos += tamanho_nome(funcao->nome) + 1;
+    }
+    for (int i = 0; i < codigo.quantidade; i++) {
+        const INSTRUCAO *instrucao = &codigo.instrucoes[i];
+        if (instrucao->op != OP_CALL) continue;
+        int nome = instrucao->arg.nome;
+        if (simbolo_do_nome[nome] >= 0) continue;
+        simbolo_do_nome[nome] = num_simbolos;
+        nome_do_simbolo[num_simbolos] = nome;
+        simbolos[num_simbolos++] = (CSB_SIMBOLO){ 0, (uint32_t)tamanho_nome(nome), CSB_FUNCAO,
+                                                  CSB_SEM_ENDERECO, 0, 0, 0, 0 };
+        tam_textos += tamanho_nome(nome) + 1;
+    }
+    for (int c = 0; c < codigo.num_constantes; c++) tam_textos += tamanho_nome(codigo.constantes[c]) + 1;
+
+    // O layout do arquivo
+    int num_linhas = com_linhas ? codigo.num_linhas : 0;
+    CSB_CABECALHO cab = {0};
+    memcpy(cab.magica, CSB_MAGICA, sizeof(cab.magica));
+    cab.versao = CSB_VERSAO;
+    cab.marca_ordem = CSB_MARCA_ORDEM;
+    cab.num_instrucoes = codigo.quantidade;
+    cab.off_instrucoes = alinha(sizeof(CSB_CABECALHO));
+    cab.num_constantes = codigo.num_constantes;
+    cab.off_constantes = alinha(cab.off_instrucoes + (size_t)cab.num_instrucoes * sizeof(CSB_INSTRUCAO));
+    cab.num_simbolos = num_simbolos;
+    cab.off_simbolos = alinha(cab.off_constantes + (size_t)cab.num_constantes * sizeof(CSB_CONSTANTE));
+    cab.num_linhas = num_linhas;
+    cab.off_linhas = alinha(cab.off_simbolos + (size_t)cab.num_simbolos * sizeof(CSB_SIMBOLO));
+    cab.tam_textos = (uint32_t)tam_textos;
+    cab.off_textos = alinha(cab.off_linhas + (size_t)cab.num_linhas * sizeof(CSB_LINHA));
+    cab.num_rotulos = codigo.num_rotulos;
+    cab.tam_dados = codigo.tam_dados;
+    cab.tamanho_arquivo = alinha(cab.off_textos + tam_textos);
+
+    char *base = calloc(1, cab.tamanho_arquivo);
+    if (base == NULL) {
+        free(posicao_rotulo); free(simbolo_do_nome); free(simbolos); free(nome_do_simbolo);
+        return false;
+    }
+    memcpy(base, &cab, sizeof(cab));
+
+    // Textos: as constantes e depois os nomes dos símbolos
+    char *textos = base + cab.off_textos;
+    uint32_t off = 0;
+    CSB_CONSTANTE *constantes = (CSB_CONSTANTE *)(base + cab.off_constantes);
+    for (int c = 0; c < codigo.num_constantes; c++) {
+        int nome = codigo.constantes[c];
+        constantes[c] = (CSB_CONSTANTE){ off, (uint32_t)tamanho_nome(nome) };
+        memcpy(textos + off, texto_nome(nome), tamanho_nome(nome) + 1);
+        off += tamanho_nome(nome) + 1;
+    }
+    CSB_SIMBOLO *destino_simbolos = (CSB_SIMBOLO *)(base + cab.off_simbolos);
+    for (int s = 0; s < num_simbolos; s++) {
+        simbolos[s].off_nome = off;
+        memcpy(textos + off, texto_nome(nome_do_simbolo[s]), simbolos[s].tam_nome + 1);
+        off += simbolos[s].tam_nome + 1;
+        destino_simbolos[s] = simbolos[s];
+    }
+
+    // Instruções, com os operandos resolvidos
+    bool ok = true;
+    CSB_INSTRUCAO *instrucoes = (CSB_INSTRUCAO *)(base + cab.off_instrucoes);
+    for (int i = 0; i < codigo.quantidade; i++) {
+        const INSTRUCAO *origem = &codigo.instrucoes[i];
+        CSB_INSTRUCAO *destino = &instrucoes[i];
+        destino->op = origem->op;
+        switch (origem->op) {
+            case OP_PUSH_REAL: destino->arg.real = origem->arg.real; break;
+            case OP_PUSH_STR: destino->arg.inteiro = origem->arg.constante; break;
+            case OP_CALL: destino->arg.inteiro = simbolo_do_nome[origem->arg.nome]; break;
+            case OP_GOFALSE:
+            case OP_GOTRUE:
+            case OP_GOTO:
+            case OP_JEQ: case OP_JNE: case OP_JLT: case OP_JGT: case OP_JLE: case OP_JGE:
+                destino->arg.inteiro = posicao_rotulo[origem->arg.rotulo];
+                if (destino->arg.inteiro < 0) {
+                    fprintf(stderr, "Desvio para o rotulo L%d, que nunca foi colocado.\n", origem->arg.rotulo);
+                    ok = false;
+                }
+                break;
+            case OP_LOAD_GX: case OP_LOAD_LX: case OP_STORE_GX: case OP_STORE_LX:
+            case OP_FSTORE_GX: case OP_FSTORE_LX:
+                destino->arg.vetor.base = origem->arg.vetor.base;
+                destino->arg.vetor.tamanho = origem->arg.vetor.tamanho;
+                break;
+            default: destino->arg.inteiro = origem->arg.inteiro; break;
+        }
+    }
+
+    CSB_LINHA *linhas = (CSB_LINHA *)(base + cab.off_linhas);
+    for (int l = 0; l < num_linhas; l++) {
+        linhas[l] = (CSB_LINHA){ (uint32_t)codigo.linhas[l].instrucao, (uint32_t)codigo.linhas[l].linha };
+    }
+
+    free(posicao_rotulo);
+    free(simbolo_do_nome);
+    free(simbolos);
+    free(nome_do_simbolo);
+
+    if (!ok) {
+        free(base);
+        return false;
+    }
+    imagem->base = base;
+    imagem->tamanho = cab.tamanho_arquivo;
+    imagem->mapeada = false;
+    aponta_secoes(imagem);
+    const char *problema = imagem_invalida(imagem);
+    if (problema != NULL) { // Só um erro do próprio gerador chega aqui
+        fprintf(stderr, "Imagem montada invalida: %s\n", problema);
+        liberar_imagem(imagem);
+        return false;
+    }
+    return true;
+}
+
+bool salvar_imagem(const IMAGEM_CSB *imagem, const char *arquivo) {
+    FILE *saida = fopen(arquivo, "wb");
+    if (saida == NULL) {
+        perror("Erro ao abrir o arquivo para escrita");
+        return false;
+    }
+    bool ok = fwrite(imagem->base, 1, imagem->tamanho, saida) == imagem->tamanho;
+    if (fclose(saida) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Erro ao gravar %s\n", arquivo);
+    return ok;
+}
+
+/** Confere que a seção [off, off + num * tam_item) cabe no arquivo e começa alinhada. */
+static bool secao_valida(uint32_t off, uint32_t num, size_t tam_item, size_t tamanho) {
+    return off % CSB_ALINHAMENTO == 0 && off <= tamanho && (uint64_t)num * tam_item <= tamanho - off;
+}
+
+/** Confere que o vetor [base, base + tamanho) cabe em `limite` células. */
+static bool vetor_valido(const CSB_INSTRUCAO *instrucao, int limite) {
+    int base = instrucao->arg.vetor.base, tamanho = instrucao->arg.vetor.tamanho;
+    return base >= 0 && tamanho > 0 && base < limite && tamanho <= limite - base;
+}
+
+/** Confere os operandos de todas as instruções; devolve a primeira inválida, ou -1. */
+static int instrucao_invalida(const IMAGEM_CSB *imagem) {
+    const CSB_CABECALHO *cab = imagem->cabecalho;
+    int n = (int)cab->num_instrucoes;
+    int tam_dados = (int)cab->tam_dados;
+    // As funções com corpo vêm na ordem dos seus endereços; os slots válidos em uma instrução
+    // são os do quadro da função que a contém
+    uint32_t s = 0;
+    int tam_quadro = 0;
+    for (int pc = 0; pc < n; pc++) {
+        for (; s < cab->num_simbolos; s++) {
+            const CSB_SIMBOLO *funcao = &imagem->simbolos[s];
+            if (funcao->tipo != CSB_FUNCAO || funcao->endereco < 0) continue;
+            if (funcao->endereco > pc) break;
+            if (funcao->endereco < pc || funcao->num_params > funcao->tam_quadro || funcao->tam_quadro > INT32_MAX) return pc;
+            tam_quadro = (int)funcao->tam_quadro;
+        }
+        const CSB_INSTRUCAO *instrucao = &imagem->instrucoes[pc];
+        int arg = instrucao->arg.inteiro;
+        switch (instrucao->op) {
+            case OP_PUSH_INT: case OP_PUSH_REAL: case OP_PUSH_CHAR: case OP_LABEL:
+            case OP_RET: case OP_NOT: case OP_EQ: case OP_NE: case OP_LT: case OP_GT:
+            case OP_LE: case OP_GE: case OP_AND: case OP_OR: case OP_DUP: case OP_POP:
+            case OP_IADD: case OP_ISUB: case OP_IMUL: case OP_IDIV: case OP_FADD: case OP_FSUB:
+            case OP_FMUL: case OP_FDIV: case OP_INEG: case OP_FNEG: case OP_I2F: case OP_F2I:
+                break;
+            case OP_PUSH_STR:
+                if (arg < 0 || (uint32_t)arg >= cab->num_constantes) return pc;
+                break;
+            case OP_CALL:
+                if (arg < 0 || (uint32_t)arg >= cab->num_simbolos || imagem->simbolos[arg].tipo != CSB_FUNCAO) return pc;
+                if (imagem->simbolos[arg].endereco >= n) return pc;
+                break;
+            case OP_GOFALSE: case OP_GOTRUE: case OP_GOTO:
+            case OP_JEQ: case OP_JNE: case OP_JLT: case OP_JGT: case OP_JLE: case OP_JGE:
+                if (arg < 0 || arg >= n) return pc;
+                break;
+            case OP_LOAD_G: case OP_STORE_G: case OP_FSTORE_G:
+                if (arg < 0 || arg >= tam_dados) return pc;
+                break;
+            case OP_LOAD_L: case OP_STORE_L: case OP_FSTORE_L:
+                if (arg < 0 || arg >= tam_quadro) return pc;
+                break;
+            case OP_LOAD_GX: case OP_STORE_GX: case OP_FSTORE_GX:
+                if (!vetor_valido(instrucao, tam_dados)) return pc;
+                break;
+            case OP_LOAD_LX: case OP_STORE_LX: case OP_FSTORE_LX:
+                if (!vetor_valido(instrucao, tam_quadro)) return pc;
+                break;
+            default:
+                return pc;
+        }
+    }
+    for (; s < cab->num_simbolos; s++) { // Uma função que começa depois do fim do código
+        if (imagem->simbolos[s].tipo == CSB_FUNCAO && imagem->simbolos[s].endereco >= 0) return n;
+    }
+    return -1;
+}
+
+/** Confere o cabeçalho e os limites das seções; os textos precisam terminar em '\0',
+ * e os operandos das instruções têm de caber nas seções e nos quadros. */
+static const char *imagem_invalida(const IMAGEM_CSB *imagem) {
+    if (imagem->tamanho < sizeof(CSB_CABECALHO)) return "arquivo menor que o cabecalho";
+    const CSB_CABECALHO *cab = imagem->base;
+    if (memcmp(cab->magica, CSB_MAGICA, sizeof(cab->magica)) != 0) return "nao e uma imagem .csb";
+    if (cab->marca_ordem != CSB_MARCA_ORDEM) return "ordem de bytes diferente da desta maquina";
+    if (cab->versao != CSB_VERSAO) return "versao do formato nao suportada";
+    if (cab->tamanho_arquivo != imagem->tamanho) return "tamanho do arquivo nao confere com o cabecalho";
+    if (!secao_valida(cab->off_instrucoes, cab->num_instrucoes, sizeof(CSB_INSTRUCAO), imagem->tamanho) ||
+        !secao_valida(cab->off_constantes, cab->num_constantes, sizeof(CSB_CONSTANTE), imagem->tamanho) ||
+        !secao_valida(cab->off_simbolos, cab->num_simbolos, sizeof(CSB_SIMBOLO), imagem->tamanho) ||
+        !secao_valida(cab->off_linhas, cab->num_linhas, sizeof(CSB_LINHA), imagem->tamanho) ||
+        !secao_valida(cab->off_textos, cab->tam_textos, 1, imagem->tamanho)) {
+        return "secao fora dos limites do arquivo";
+    }
+    if (cab->tam_textos > 0 && ((const char *)imagem->base)[cab->off_textos + cab->tam_textos - 1] != '\0') {
+        return "secao de textos sem terminador";
+    }
+    for (uint32_t c = 0; c < cab->num_constantes; c++) {
+        if (imagem->constantes[c].off_texto >= cab->tam_textos) return "constante fora da secao de textos";
+    }
+    for (uint32_t s = 0; s < cab->num_simbolos; s++) {
+        if (imagem->simbolos[s].off_nome >= cab->tam_textos) return "simbolo fora da secao de textos";
+    }
+    int pc = instrucao_invalida(imagem);
+    if (pc >= 0) {
+        static char problema[80];
+        snprintf(problema, sizeof(problema), "operando invalido na instrucao %d", pc);
+        return problema;
+    }
+    return NULL;
+}
+
+bool carregar_imagem(const char *arquivo, IMAGEM_CSB *imagem) {
+    memset(imagem, 0, sizeof(*imagem));
+#ifndef _WIN32
+    int fd_imagem = open(arquivo, O_RDONLY);
+    if (fd_imagem < 0) {
+        perror(arquivo);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd_imagem, &info) != 0 || info.st_size == 0) {
+        fprintf(stderr, "%s: arquivo vazio ou ilegivel\n", arquivo);
+        close(fd_imagem);
+        return false;
+    }
+    void *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd_imagem, 0);
+    close(fd_imagem);
+    if (base == MAP_FAILED) {
+        perror(arquivo);
+        return false;
+    }
+    imagem->base = base;
+    imagem->tamanho = (size_t)info.st_size;
+    imagem->mapeada = true;
+#else
+    FILE *entrada = fopen(arquivo, "rb");
+    if (entrada == NULL) {
+        perror(arquivo);
+        return false;
+    }
+    fseek(entrada, 0, SEEK_END);
+    long tamanho = ftell(entrada);
+    fseek(entrada, 0, SEEK_SET);
+    void *base = tamanho > 0 ? malloc((size_t)tamanho) : NULL;
+    if (base == NULL || fread(base, 1, (size_t)tamanho, entrada) != (size_t)tamanho) {
+        fprintf(stderr, "%s: arquivo vazio ou ilegivel\n", arquivo);
+        free(base);
+        fclose(entrada);
+        return false;
+    }
+    fclose(entrada);
+    imagem->base = base;
+    imagem->tamanho = (size_t)tamanho;
+#endif
+    const char *problema = imagem->tamanho < sizeof(CSB_CABECALHO) ? "arquivo menor que o cabecalho" : NULL;
+    if (problema == NULL) {
+        aponta_secoes(imagem);
+        problema = imagem_invalida(imagem);
+    }
+    if (problema != NULL) {
+        fprintf(stderr, "%s: %s\n", arquivo, problema);
+        liberar_imagem(imagem);
+        return false;
+    }
+    return true;
+}
+
+void liberar_imagem(IMAGEM_CSB *imagem) {
+    if (imagem->base != NULL) {
+#ifndef _WIN32
+        if (imagem->mapeada) munmap(imagem->base, imagem->tamanho);
+        else free(imagem->base);
+#else
+        free(imagem->base);
+#endif
+    }
+    memset(imagem, 0, sizeof(*imagem));
+}
+
+const char *nome_simbolo(const IMAGEM_CSB *imagem, int indice) {
+    return imagem->textos + imagem->simbolos[indice].off_nome;
+}
+
+int linha_da_instrucao(const IMAGEM_CSB *imagem, int pc) {
+    // Busca binária pela última entrada que começa em ou antes de pc
+    int ini = 0, fim = (int)imagem->cabecalho->num_linhas - 1, linha = 0;
+    while (ini <= fim) {
+        int meio = (ini + fim) / 2;
+        if ((int)imagem->linhas[meio].instrucao <= pc) {
+            linha = (int)imagem->linhas[meio].linha;
+            ini = meio + 1;
+        } else {
+            fim = meio - 1;
+        }
+    }
+    return linha;
+}
+
+/** Escreve uma instrução da imagem no mesmo texto de imprime_instrucao. */
+static void desmonta_instrucao(FILE *saida, const IMAGEM_CSB *imagem, const CSB_INSTRUCAO *instrucao) {
+    switch (instrucao->op) {
+        case OP_PUSH_INT: fprintf(saida, "PUSH %d", instrucao->arg.inteiro); break;
+        case OP_PUSH_REAL: fprintf(saida, "PUSH %f", instrucao->arg.real); break;
+        case OP_PUSH_CHAR: fprintf(saida, "PUSH '%c'", instrucao->arg.inteiro); break;
+        case OP_PUSH_STR:
+            fprintf(saida, "PUSH \"%s\"", imagem->textos + imagem->constantes[instrucao->arg.inteiro].off_texto);
+            break;
+        // O destino de um desvio é a instrução LABEL; o número do rótulo está nela
+        case OP_GOFALSE: fprintf(saida, "GOFALSE L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_GOTO: fprintf(saida, "GOTO L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_LABEL: fprintf(saida, "LABEL L%d", instrucao->arg.inteiro); break;
+        case OP_CALL: fprintf(saida, "CALL %s", nome_simbolo(imagem, instrucao->arg.inteiro)); break;
+        case OP_RET: fputs("RET", saida); break;
+        case OP_NOT: fputs("NOT", saida); break;
+        case OP_EQ: fputs("EQ", saida); break;
+        case OP_NE: fputs("NE", saida); break;
+        case OP_LT: fputs("LT", saida); break;
+        case OP_GT: fputs("GT", saida); break;
+        case OP_LE: fputs("LE", saida); break;
+        case OP_GE: fputs("GE", saida); break;
+        case OP_AND: fputs("AND", saida); break;
+        case OP_OR: fputs("OR", saida); break;
+        case OP_LOAD_G: fprintf(saida, "LOAD_G %d", instrucao->arg.inteiro); break;
+        case OP_LOAD_L: fprintf(saida, "LOAD_L %d", instrucao->arg.inteiro); break;
+        case OP_STORE_G: fprintf(saida, "STORE_G %d", instrucao->arg.inteiro); break;
+        case OP_STORE_L: fprintf(saida, "STORE_L %d", instrucao->arg.inteiro); break;
+        case OP_LOAD_GX: fprintf(saida, "LOAD_GX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_LOAD_LX: fprintf(saida, "LOAD_LX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_STORE_GX: fprintf(saida, "STORE_GX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_STORE_LX: fprintf(saida, "STORE_LX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_FSTORE_G: fprintf(saida, "FSTORE_G %d", instrucao->arg.inteiro); break;
+        case OP_FSTORE_L: fprintf(saida, "FSTORE_L %d", instrucao->arg.inteiro); break;
+        case OP_FSTORE_GX: fprintf(saida, "FSTORE_GX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_FSTORE_LX: fprintf(saida, "FSTORE_LX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_DUP: fputs("DUP", saida); break;
+        case OP_POP: fputs("POP", saida); break;
+        case OP_GOTRUE: fprintf(saida, "GOTRUE L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_JEQ: fprintf(saida, "JEQ L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_JNE: fprintf(saida, "JNE L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_JLT: fprintf(saida, "JLT L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_JGT: fprintf(saida, "JGT L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_JLE: fprintf(saida, "JLE L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_JGE: fprintf(saida, "JGE L%d", imagem->instrucoes[instrucao->arg.inteiro].arg.inteiro); break;
+        case OP_IADD: fputs("IADD", saida); break;
+        case OP_ISUB: fputs("ISUB", saida); break;
+        case OP_IMUL: fputs("IMUL", saida); break;
+        case OP_IDIV: fputs("IDIV", saida); break;
+        case OP_FADD: fputs("FADD", saida); break;
+        case OP_FSUB: fputs("FSUB", saida); break;
+        case OP_FMUL: fputs("FMUL", saida); break;
+        case OP_FDIV: fputs("FDIV", saida); break;
+        case OP_INEG: fputs("INEG", saida); break;
+        case OP_FNEG: fputs("FNEG", saida); break;
+        case OP_I2F: fputs("I2F", saida); break;
+        case OP_F2I: fputs("F2I", saida); break;
+        default: fprintf(saida, "?? (opcode %u)", instrucao->op); break;
+    }
+}
+
+void desmontar_imagem(FILE *saida, const IMAGEM_CSB *imagem, bool detalhes) {
+    const CSB_CABECALHO *cab = imagem->cabecalho;
+    uint32_t proxima_linha = 0;
+    for (uint32_t i = 0; i < cab->num_instrucoes; i++) {
+        if (detalhes) {
+            for (uint32_t s = 0; s < cab->num_simbolos; s++) {
+                const CSB_SIMBOLO *simbolo = &imagem->simbolos[s];
+                if (simbolo->tipo == CSB_FUNCAO && simbolo->endereco == (int32_t)i) {
+                    fprintf(saida, "; funcao %s (%u parametros, %u slots)\n", nome_simbolo(imagem, s),
+                            simbolo->num_params, simbolo->tam_quadro);
+                }
+            }
+            while (proxima_linha < cab->num_linhas && imagem->linhas[proxima_linha].instrucao <= i) {
+                fprintf(saida, "; linha %u\n", imagem->linhas[proxima_linha++].linha);
+            }
+            fprintf(saida, "%6u  ", i);
+        }
+        desmonta_instrucao(saida, imagem, &imagem->instrucoes[i]);
+        fputc('\n', saida);
+    }
+}
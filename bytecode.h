@@ -0,0 +1,162 @@
+/**
+ * @file bytecode.h
+ * @brief Imagem binária (.csb) do código da máquina de pilha.
+ *
+ * Um arquivo .csb é a imagem do código pronta para execução: todas as seções têm
+ * registros de tamanho fixo, alinhados a 16 bytes, e os operandos já estão
+ * resolvidos (desvios apontam para a instrução de destino, nomes para a tabela de
+ * símbolos, strings para o pool de constantes). Carregar é só mapear o arquivo
+ * (mmap) e apontar para as seções: não há leitura de texto nem relocação.
+ *
+ * Layout (todos os deslocamentos contam a partir do início do arquivo):
+ *
+ *     CSB_CABECALHO                   64 bytes: mágica, versão, marca de ordem dos bytes, seções
+ *     CSB_INSTRUCAO[num_instrucoes]   16 bytes cada: opcode (OPCODE) e operando
+ *     CSB_CONSTANTE[num_constantes]   strings do código (PUSH "...")
+ *     CSB_SIMBOLO[num_simbolos]       funções (com endereço de início, ou sem corpo se só declaradas)
+ *     CSB_LINHA[num_linhas]           opcional: linha do fonte a partir de cada instrução
+ *     textos                          os textos de constantes e símbolos, terminados em '\0'
+ *
+ * Operando de cada instrução no arquivo:
+ * - OP_PUSH_INT, OP_PUSH_CHAR: o valor; OP_PUSH_REAL: o double;
+ * - OP_PUSH_STR: índice em CSB_CONSTANTE; OP_CALL: índice em CSB_SIMBOLO;
+ * - OP_GOFALSE, OP_GOTRUE, OP_GOTO, OP_JEQ .. OP_JGE: índice da instrução de destino (o LABEL);
+ * - OP_LABEL: o número do rótulo, para o desmontador reproduzir "LABEL Ln";
+ * - OP_LOAD_G, OP_STORE_G, OP_FSTORE_G: índice no segmento de dados (`tam_dados` células);
+ * - OP_LOAD_L, OP_STORE_L, OP_FSTORE_L: slot no quadro da função (`tam_quadro` do símbolo dela);
+ * - OP_LOAD_GX, OP_LOAD_LX e os STOREs de elemento: a célula base e o tamanho do vetor.
+ *
+ * Os inteiros são gravados na ordem de bytes da máquina que gerou o arquivo; a
+ * marca de ordem no cabeçalho faz o carregador recusar imagens da ordem oposta.
+ */
+
+#ifndef _BYTECODE_
+#define _BYTECODE_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define CSB_MAGICA "CSB"                ///< Os 4 primeiros bytes do arquivo ("CSB\0").
+#define CSB_VERSAO 4                    ///< Muda a cada alteração incompatível do formato.
+#define CSB_MARCA_ORDEM 0x01020304u     ///< Lida de volta com outro valor se a ordem dos bytes não bate.
+#define CSB_ALINHAMENTO 16              ///< Alinhamento do início de cada seção.
+#define CSB_SEM_ENDERECO (-1)           ///< Endereço de um símbolo sem corpo (variável, ou função só declarada).
+
+/** @brief Cabeçalho do arquivo. */
+typedef struct {
+    char magica[4];
+    uint32_t versao;
+    uint32_t marca_ordem;
+    uint32_t tamanho_arquivo;
+    uint32_t num_instrucoes, off_instrucoes;
+    uint32_t num_constantes, off_constantes;
+    uint32_t num_simbolos, off_simbolos;
+    uint32_t num_linhas, off_linhas;    ///< num_linhas = 0 quando não há tabela de linhas.
+    uint32_t tam_textos, off_textos;
+    uint32_t num_rotulos;
+    uint32_t tam_dados;                 ///< Células do segmento de dados (as globais).
+} CSB_CABECALHO;
+
+/** @brief Uma instrução: o mesmo layout de INSTRUCAO, com tipos de tamanho fixo. */
+typedef struct {
+    uint32_t op;            ///< Um OPCODE.
+    uint32_t reservado;     ///< Sempre 0.
+    union {
+        int32_t inteiro;    ///< Valor, índice ou rótulo (ver o cabeçalho deste arquivo).
+        double real;        ///< OP_PUSH_REAL.
+        struct {
+            int32_t base;
+            int32_t tamanho;
+        } vetor;            ///< OP_LOAD_GX, OP_LOAD_LX, OP_STORE_GX, ...
+        uint8_t bytes[8];
+    } arg;
+} CSB_INSTRUCAO;
+
+/** @brief Uma constante string. */
+typedef struct {
+    uint32_t off_texto;     ///< Deslocamento do texto na seção de textos.
+    uint32_t tamanho;       ///< Tamanho do texto, sem o '\0'.
+} CSB_CONSTANTE;
+
+/** @brief Tipos de símbolo. */
+typedef enum {
+    CSB_VARIAVEL,
+    CSB_FUNCAO
+} CSB_TIPO_SIMBOLO;
+
+/** @brief Um símbolo referenciado pelo código. */
+typedef struct {
+    uint32_t off_nome;      ///< Deslocamento do nome na seção de textos.
+    uint32_t tam_nome;
+    uint32_t tipo;          ///< Um CSB_TIPO_SIMBOLO.
+    int32_t endereco;       ///< Primeira instrução do corpo (funções), ou CSB_SEM_ENDERECO.
+    uint32_t num_params;    ///< Parâmetros (funções).
+    uint32_t com_retorno;   ///< 1 se a função devolve um valor (não é void).
+    uint32_t tam_quadro;    ///< Slots do quadro (funções): os parâmetros e depois as locais.
+    uint32_t reservado;     ///< Sempre 0.
+} CSB_SIMBOLO;
+
+/** @brief Uma entrada da tabela de linhas. */
+typedef struct {
+    uint32_t instrucao;     ///< A partir desta instrução...
+    uint32_t linha;         ///< ...o código veio desta linha do fonte.
+} CSB_LINHA;
+
+/** @brief Uma imagem carregada (ou montada em memória): ponteiros para as seções. */
+typedef struct {
+    const CSB_CABECALHO *cabecalho;
+    const CSB_INSTRUCAO *instrucoes;
+    const CSB_CONSTANTE *constantes;
+    const CSB_SIMBOLO *simbolos;
+    const CSB_LINHA *linhas;
+    const char *textos;
+
+    void *base;             ///< O buffer inteiro (para munmap/free).
+    size_t tamanho;
+    bool mapeada;           ///< true se veio de mmap (senão, de malloc).
+} IMAGEM_CSB;
+
+/**
+ * @brief Monta, em memória, a imagem do código gerado até agora (ver gerador_codigo.h).
+ * @param imagem Recebe a imagem; libere com `liberar_imagem`.
+ * @param com_linhas Inclui a tabela de linhas.
+ * @return false se um desvio aponta para um rótulo que nunca foi colocado (ou se a
+ * imagem montada não passa nas conferências de `carregar_imagem`).
+ */
+bool montar_imagem(IMAGEM_CSB *imagem, bool com_linhas);
+
+/** @brief Grava uma imagem montada em um arquivo .csb. @return false se o arquivo não pôde ser escrito. */
+bool salvar_imagem(const IMAGEM_CSB *imagem, const char *arquivo);
+
+/**
+ * @brief Carrega um .csb com mmap (ou lendo o arquivo, onde não há mmap).
+ *
+ * O cabeçalho, os limites das seções e os operandos das instruções (índices,
+ * destinos de desvio, células e slots) são conferidos uma vez, aqui; depois as
+ * instruções são usadas direto do arquivo mapeado.
+ *
+ * @return false (com uma mensagem em stderr) se o arquivo não existe ou não é uma imagem válida.
+ */
+bool carregar_imagem(const char *arquivo, IMAGEM_CSB *imagem);
+
+/** @brief Libera uma imagem montada ou carregada. */
+void liberar_imagem(IMAGEM_CSB *imagem);
+
+/** @brief Nome do símbolo `indice`. */
+const char *nome_simbolo(const IMAGEM_CSB *imagem, int indice);
+
+/** @brief Linha do fonte da instrução `pc`, ou 0 se a imagem não tem tabela de linhas. */
+int linha_da_instrucao(const IMAGEM_CSB *imagem, int pc);
+
+/**
+ * @brief Desmonta a imagem para o texto da máquina de pilha.
+ *
+ * Sem `detalhes`, a saída é idêntica ao codigo_maquina.txt do mesmo programa.
+ * Com `detalhes`, cada instrução vem precedida do seu índice, e o início de cada
+ * função e as mudanças de linha aparecem como comentários (';').
+ */
+void desmontar_imagem(FILE *saida, const IMAGEM_CSB *imagem, bool detalhes);
+
+#endif // _BYTECODE_
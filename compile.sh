@@ -1 +1 @@
-gcc main.c analex.c anasint.c -o analisador_cshort
\ No newline at end of file
+gcc gera_afd.c -o gera_afd && ./gera_afd AFD/afd.jff afd_tabela.h && gcc main.c analex.c anasint.c tabela_simbolos.c tabela_nomes.c gerador_codigo.c rastro.c bytecode.c interpretador.c otimizador.c -o analisador_cshort -pthread
\ No newline at end of file
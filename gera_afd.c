@@ -0,0 +1,384 @@
+/*
+    gera_afd.c
+
+    Gerador da tabela de transições do analisador léxico.
+    Lê o AFD desenhado no JFLAP (AFD/afd.jff) e escreve um cabeçalho C (afd_tabela.h) com:
+        - a classe de cada caractere (afd_classe);
+        - a tabela de transições estado x classe (afd_transicao);
+        - a marcação dos estados finais (afd_final);
+        - uma constante AFD_Qn para cada estado qn do diagrama.
+
+    Uso: ./gera_afd AFD/afd.jff afd_tabela.h
+
+    Convenções dos rótulos das transições no diagrama:
+        LETRA, DÍGITO, TAB, ESPAÇO EM BRANCO, APÓSTROFO, ASPAS, BARRA, BARRA_INVERTIDA,
+        BARRA_VERTICAL, EXCLAMAÇÃO, PONTO, EOF  --> classes nomeadas
+        \N, \R, \                               --> quebra de linha, retorno de carro, barra invertida
+        qualquer outro caractere isolado        --> o próprio caractere (inclusive ',')
+        a, b, c                                 --> união dos itens separados por vírgula
+        CH != a, b                              --> caracteres imprimíveis (isprint) exceto os listados
+        OUTRO                                   --> todo o resto, exceto EOF (o caractere é consumido)
+        OUTRO*                                  --> todo o resto, inclusive EOF (o caractere é devolvido)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#define MAX_ESTADOS 127          // O bit 0x80 marca o retrocesso e 0xFF é o erro
+#define MAX_TRANSICOES 512
+#define MAX_NOME 32
+#define MAX_ROTULO 64
+#define NUM_SIMBOLOS 257         // 256 bytes + EOF
+#define SIMBOLO_EOF 256
+
+#define ERRO 0xFF
+#define RETROCEDE 0x80
+
+typedef struct
+{
+    char nome[MAX_NOME];
+    bool inicial;
+    bool final;
+    bool existe;
+} Estado;
+
+typedef struct
+{
+    int de;
+    int para;
+    char rotulo[MAX_ROTULO];
+} Transicao;
+
+static Estado estados[MAX_ESTADOS];
+static int num_estados = 0;
+static Transicao transicoes[MAX_TRANSICOES];
+static int num_transicoes = 0;
+
+// Tabela completa (estado x símbolo) antes do agrupamento em classes
+static unsigned char tabela[MAX_ESTADOS][NUM_SIMBOLOS];
+
+static void falha(const char *msg, const char *detalhe)
+{
+    fprintf(stderr, "gera_afd: %s%s%s\n", msg, detalhe ? ": " : "", detalhe ? detalhe : "");
+    exit(1);
+}
+
+static char *le_arquivo(const char *caminho)
+{
+    FILE *f = fopen(caminho, "rb");
+    if (f == NULL) falha("nao foi possivel abrir", caminho);
+    fseek(f, 0, SEEK_END);
+    long tam = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(tam + 1);
+    if (buf == NULL || fread(buf, 1, tam, f) != (size_t)tam) falha("erro de leitura", caminho);
+    buf[tam] = '\0';
+    fclose(f);
+    return buf;
+}
+
+/* Copia o conteúdo de <tag>...</tag> (a partir de 'p' e antes de 'limite') desfazendo as entidades XML */
+static bool le_tag(const char *p, const char *limite, const char *tag, char *destino, int tam)
+{
+    char abre[MAX_NOME], fecha[MAX_NOME];
+    snprintf(abre, sizeof(abre), "<%s>", tag);
+    snprintf(fecha, sizeof(fecha), "</%s>", tag);
+
+    const char *ini = strstr(p, abre);
+    if (ini == NULL || ini > limite) return false;
+    ini += strlen(abre);
+    const char *fim = strstr(ini, fecha);
+    if (fim == NULL || fim > limite) return false;
+
+    int n = 0;
+    while (ini < fim && n < tam - 1)
+    {
+        if (strncmp(ini, "&amp;", 5) == 0) { destino[n++] = '&'; ini += 5; }
+        else if (strncmp(ini, "&lt;", 4) == 0) { destino[n++] = '<'; ini += 4; }
+        else if (strncmp(ini, "&gt;", 4) == 0) { destino[n++] = '>'; ini += 4; }
+        else if (strncmp(ini, "&quot;", 6) == 0) { destino[n++] = '"'; ini += 6; }
+        else if (strncmp(ini, "&apos;", 6) == 0) { destino[n++] = '\''; ini += 6; }
+        else destino[n++] = *ini++;
+    }
+    destino[n] = '\0';
+    return true;
+}
+
+static void le_jff(const char *xml)
+{
+    const char *p = xml;
+
+    // Estados: <state id="n" name="qn"> ... </state>
+    while ((p = strstr(p, "<state ")) != NULL)
+    {
+        const char *fim = strstr(p, "</state>");
+        if (fim == NULL) falha("estado sem </state>", NULL);
+
+        int id;
+        char nome[MAX_NOME];
+        if (sscanf(p, "<state id=\"%d\" name=\"%31[^\"]\"", &id, nome) != 2) falha("estado mal formado", NULL);
+        if (id < 0 || id >= MAX_ESTADOS) falha("id de estado fora do limite", nome);
+
+        strcpy(estados[id].nome, nome);
+        estados[id].existe = true;
+        estados[id].inicial = strstr(p, "<initial/>") != NULL && strstr(p, "<initial/>") < fim;
+        estados[id].final = strstr(p, "<final/>") != NULL && strstr(p, "<final/>") < fim;
+        if (id + 1 > num_estados) num_estados = id + 1;
+        p = fim;
+    }
+
+    // Transições: <transition><from/><to/><read/></transition>
+    p = xml;
+    while ((p = strstr(p, "<transition>")) != NULL)
+    {
+        const char *fim = strstr(p, "</transition>");
+        char de[16], para[16];
+        if (fim == NULL) falha("transicao sem </transition>", NULL);
+        if (num_transicoes == MAX_TRANSICOES) falha("transicoes demais", NULL);
+
+        Transicao *tr = &transicoes[num_transicoes++];
+        if (!le_tag(p, fim, "from", de, sizeof(de)) || !le_tag(p, fim, "to", para, sizeof(para))) falha("transicao sem origem/destino", NULL);
+        if (!le_tag(p, fim, "read", tr->rotulo, sizeof(tr->rotulo))) tr->rotulo[0] = '\0';
+        tr->de = atoi(de);
+        tr->para = atoi(para);
+        if (!estados[tr->de].existe || !estados[tr->para].existe) falha("transicao para estado inexistente", tr->rotulo);
+        p = fim;
+    }
+}
+
+static void apara(char *s)
+{
+    char *ini = s;
+    while (*ini == ' ') ini++;
+    memmove(s, ini, strlen(ini) + 1);
+    int n = (int)strlen(s);
+    while (n > 0 && s[n - 1] == ' ') s[--n] = '\0';
+}
+
+/* Marca em 'conj' os símbolos de um item de rótulo (nome de classe ou caractere isolado) */
+static void marca_item(const char *item, bool conj[NUM_SIMBOLOS], const char *rotulo)
+{
+    if (strcmp(item, "LETRA") == 0)
+    {
+        for (int c = 'a'; c <= 'z'; c++) conj[c] = true;
+        for (int c = 'A'; c <= 'Z'; c++) conj[c] = true;
+    }
+    else if (strcmp(item, "DÍGITO") == 0)
+    {
+        for (int c = '0'; c <= '9'; c++) conj[c] = true;
+    }
+    else if (strcmp(item, "TAB") == 0) conj['\t'] = true;
+    else if (strcmp(item, "ESPAÇO EM BRANCO") == 0) conj[' '] = true;
+    else if (strcmp(item, "APÓSTROFO") == 0) conj['\''] = true;
+    else if (strcmp(item, "ASPAS") == 0) conj['"'] = true;
+    else if (strcmp(item, "BARRA") == 0) conj['/'] = true;
+    else if (strcmp(item, "BARRA_INVERTIDA") == 0 || strcmp(item, "\\") == 0) conj['\\'] = true;
+    else if (strcmp(item, "BARRA_VERTICAL") == 0) conj['|'] = true;
+    else if (strcmp(item, "EXCLAMAÇÃO") == 0) conj['!'] = true;
+    else if (strcmp(item, "PONTO") == 0) conj['.'] = true;
+    else if (strcmp(item, "EOF") == 0) conj[SIMBOLO_EOF] = true;
+    else if (strcmp(item, "\\N") == 0) conj['\n'] = true;
+    else if (strcmp(item, "\\R") == 0) conj['\r'] = true;
+    else if (strlen(item) == 1) conj[(unsigned char)item[0]] = true;
+    else falha("item de rotulo desconhecido", rotulo);
+}
+
+/* Converte o rótulo de uma transição no conjunto de símbolos que ela lê */
+static void conjunto_do_rotulo(const char *rotulo, bool conj[NUM_SIMBOLOS])
+{
+    char lista[MAX_ROTULO];
+    bool nega = false;
+
+    memset(conj, 0, NUM_SIMBOLOS * sizeof(bool));
+    if (strncmp(rotulo, "CH != ", 6) == 0)
+    {
+        nega = true;
+        strcpy(lista, rotulo + 6);
+    }
+    else
+    {
+        strcpy(lista, rotulo);
+    }
+
+    bool itens[NUM_SIMBOLOS] = { false };
+    if (strlen(lista) == 1)
+    {
+        // Um caractere isolado (inclusive a própria vírgula)
+        itens[(unsigned char)lista[0]] = true;
+    }
+    else
+    {
+        for (char *item = strtok(lista, ","); item != NULL; item = strtok(NULL, ","))
+        {
+            apara(item);
+            if (item[0] == '\0') falha("item vazio no rotulo", rotulo);
+            marca_item(item, itens, rotulo);
+        }
+    }
+
+    for (int s = 0; s < NUM_SIMBOLOS; s++)
+    {
+        conj[s] = nega ? (s < 256 && isprint(s) && !itens[s]) : itens[s];
+    }
+}
+
+static bool eh_outro(const char *rotulo, bool *retrocede)
+{
+    if (strncmp(rotulo, "OUTRO", 5) != 0) return false;
+    *retrocede = strchr(rotulo, '*') != NULL;
+    return true;
+}
+
+static void monta_tabela()
+{
+    memset(tabela, ERRO, sizeof(tabela));
+
+    // Primeiro as transições explícitas; um símbolo lido por duas transições torna o autômato não determinístico
+    for (int i = 0; i < num_transicoes; i++)
+    {
+        Transicao *tr = &transicoes[i];
+        bool retrocede;
+        if (eh_outro(tr->rotulo, &retrocede)) continue;
+
+        bool conj[NUM_SIMBOLOS];
+        conjunto_do_rotulo(tr->rotulo, conj);
+        for (int s = 0; s < NUM_SIMBOLOS; s++)
+        {
+            if (!conj[s]) continue;
+            if (tabela[tr->de][s] != ERRO && (tabela[tr->de][s] & ~RETROCEDE) != tr->para)
+            {
+                char msg[128];
+                snprintf(msg, sizeof(msg), "%s le o simbolo %d em duas transicoes", estados[tr->de].nome, s);
+                falha("AFD nao deterministico", msg);
+            }
+            // O fim do arquivo nunca é consumido: a transição por EOF sempre retrocede
+            tabela[tr->de][s] = (unsigned char)(tr->para | (s == SIMBOLO_EOF ? RETROCEDE : 0));
+        }
+    }
+
+    // Depois o "OUTRO": completa o estado com tudo o que ainda não tem transição
+    for (int i = 0; i < num_transicoes; i++)
+    {
+        Transicao *tr = &transicoes[i];
+        bool retrocede;
+        if (!eh_outro(tr->rotulo, &retrocede)) continue;
+
+        for (int s = 0; s < NUM_SIMBOLOS; s++)
+        {
+            if (s == SIMBOLO_EOF && !retrocede) continue; // Não há como consumir o fim do arquivo
+            if (tabela[tr->de][s] == ERRO)
+            {
+                tabela[tr->de][s] = (unsigned char)(tr->para | (retrocede ? RETROCEDE : 0));
+            }
+        }
+    }
+}
+
+/* Agrupa em uma mesma classe os símbolos que têm a mesma coluna na tabela */
+static int agrupa_classes(int classe_de[NUM_SIMBOLOS], int representante[NUM_SIMBOLOS])
+{
+    int num_classes = 0;
+
+    // O EOF sempre fica em uma classe própria, a última, para não depender de afd_classe[]
+    for (int s = 0; s < 256; s++)
+    {
+        int c;
+        for (c = 0; c < num_classes; c++)
+        {
+            int r = representante[c];
+            int e;
+            for (e = 0; e < num_estados; e++)
+            {
+                if (tabela[e][s] != tabela[e][r]) break;
+            }
+            if (e == num_estados) break;
+        }
+        if (c == num_classes) representante[num_classes++] = s;
+        classe_de[s] = c;
+    }
+    representante[num_classes] = SIMBOLO_EOF;
+    classe_de[SIMBOLO_EOF] = num_classes++;
+    return num_classes;
+}
+
+static void escreve_cabecalho(const char *caminho, const char *origem)
+{
+    int classe_de[NUM_SIMBOLOS];
+    int representante[NUM_SIMBOLOS];
+    int num_classes = agrupa_classes(classe_de, representante);
+    int inicial = -1;
+
+    for (int e = 0; e < num_estados; e++)
+    {
+        if (!estados[e].existe) falha("ids de estados nao sao contiguos", NULL);
+        if (estados[e].inicial) inicial = e;
+    }
+    if (inicial < 0) falha("AFD sem estado inicial", NULL);
+
+    FILE *f = fopen(caminho, "w");
+    if (f == NULL) falha("nao foi possivel criar", caminho);
+
+    fprintf(f, "/* Arquivo gerado por gera_afd a partir de %s. NAO EDITE: altere o diagrama e gere novamente. */\n", origem);
+    fprintf(f, "#ifndef AFD_TABELA_H\n#define AFD_TABELA_H\n\n");
+    fprintf(f, "#define AFD_NUM_ESTADOS %d\n", num_estados);
+    fprintf(f, "#define AFD_NUM_CLASSES %d\n", num_classes);
+    fprintf(f, "#define AFD_CLASSE_EOF %d\n", num_classes - 1);
+    fprintf(f, "#define AFD_ESTADO_INICIAL %d\n", inicial);
+    fprintf(f, "#define AFD_ERRO 0x%02X      // Transição inexistente no diagrama\n", ERRO);
+    fprintf(f, "#define AFD_RETROCEDE 0x%02X // Transição por OUTRO*: o caractere não é consumido\n\n", RETROCEDE);
+
+    for (int e = 0; e < num_estados; e++)
+    {
+        char maiusc[MAX_NOME];
+        int i;
+        for (i = 0; estados[e].nome[i]; i++) maiusc[i] = (char)toupper((unsigned char)estados[e].nome[i]);
+        maiusc[i] = '\0';
+        fprintf(f, "#define AFD_%s %d\n", maiusc, e);
+    }
+
+    fprintf(f, "\nstatic const unsigned char afd_classe[256] =\n{");
+    for (int s = 0; s < 256; s++)
+    {
+        fprintf(f, "%s%2d,", s % 16 == 0 ? "\n    " : " ", classe_de[s]);
+    }
+    fprintf(f, "\n};\n");
+
+    fprintf(f, "\nstatic const unsigned char afd_transicao[AFD_NUM_ESTADOS][AFD_NUM_CLASSES] =\n{\n");
+    for (int e = 0; e < num_estados; e++)
+    {
+        fprintf(f, "    /* %-4s */ {", estados[e].nome);
+        for (int c = 0; c < num_classes; c++)
+        {
+            fprintf(f, "%s0x%02X", c ? "," : "", tabela[e][representante[c]]);
+        }
+        fprintf(f, "},\n");
+    }
+    fprintf(f, "};\n");
+
+    fprintf(f, "\nstatic const unsigned char afd_final[AFD_NUM_ESTADOS] =\n{");
+    for (int e = 0; e < num_estados; e++)
+    {
+        fprintf(f, "%s%d,", e % 16 == 0 ? "\n    " : " ", estados[e].final ? 1 : 0);
+    }
+    fprintf(f, "\n};\n\n#endif\n");
+    fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Uso: %s <afd.jff> <afd_tabela.h>\n", argv[0]);
+        return 1;
+    }
+
+    char *xml = le_arquivo(argv[1]);
+    le_jff(xml);
+    monta_tabela();
+    escreve_cabecalho(argv[2], argv[1]);
+    free(xml);
+    return 0;
+}
@@ -2,37 +2,212 @@
 #include <stdlib.h>
 #include <string.h>
 #include "gerador_codigo.h"
+#include "tabela_nomes.h"
+#include "analex.h"
 
-#define MAX_CODIGO 1000
-#define TAM_LINHA 100
+#define INSTRUCOES_INICIAIS 1024
+#define CONSTANTES_INICIAIS 64
+#define TAM_BUFFER_SAIDA (1024 * 1024)
 
 // Buffer para armazenar as instruções da máquina de pilha
-static char codigo[MAX_CODIGO][TAM_LINHA];
-static int linha_atual = 0;
-
-// Contador para geração de rótulos únicos
-static int contador_rotulo = 0;
-
-// Gera uma instrução e adiciona ao buffer
-void gera(char *instrucao) {
-    if (linha_atual < MAX_CODIGO) {
-        strncpy(codigo[linha_atual], instrucao, TAM_LINHA);
-        linha_atual++;
-    } else {
-        fprintf(stderr, "Erro: limite de instruções excedido.\n");
+CODIGO codigo;
+
+// Slots já reservados no quadro da função sendo compilada
+static int tam_quadro_atual = 0;
+
+// Para cada código de nome, a posição + 1 da sua constante no pool (0 = ainda não está lá)
+static int *constante_do_nome = NULL;
+static int cap_constante_do_nome = 0;
+
+// Garante espaço para mais um item em um vetor que dobra quando enche
+static void cresce(void **vetor, int quantidade, int *capacidade, size_t tam_item, int inicial) {
+    if (quantidade < *capacidade) return;
+    int nova = *capacidade ? *capacidade * 2 : inicial;
+    void *novo = realloc(*vetor, (size_t)nova * tam_item);
+    if (novo == NULL) error("Memoria insuficiente para o codigo gerado.");
+    *vetor = novo;
+    *capacidade = nova;
+}
+
+// Abre espaço para mais uma instrução, dobrando o buffer quando ele enche
+static INSTRUCAO *nova_instrucao(OPCODE op) {
+    cresce((void **)&codigo.instrucoes, codigo.quantidade, &codigo.capacidade, sizeof(INSTRUCAO), INSTRUCOES_INICIAIS);
+    if (codigo.num_linhas == 0 || codigo.linhas[codigo.num_linhas - 1].linha != contLinha) {
+        cresce((void **)&codigo.linhas, codigo.num_linhas, &codigo.cap_linhas, sizeof(LINHA_GERADA), INSTRUCOES_INICIAIS);
+        codigo.linhas[codigo.num_linhas++] = (LINHA_GERADA){ codigo.quantidade, contLinha };
+    }
+    INSTRUCAO *instrucao = &codigo.instrucoes[codigo.quantidade++];
+    instrucao->op = op;
+    instrucao->arg.real = 0; // Zera o operando inteiro, qualquer que seja o campo usado
+    return instrucao;
+}
+
+// Gera uma instrução sem operando e adiciona ao buffer
+void gera(OPCODE op) {
+    nova_instrucao(op);
+}
+
+void gera_int(OPCODE op, int valor) {
+    nova_instrucao(op)->arg.inteiro = valor;
+}
+
+void gera_real(double valor) {
+    nova_instrucao(OP_PUSH_REAL)->arg.real = valor;
+}
+
+// O pool guarda cada texto uma vez; a busca é pelo código do nome, sem comparar strings
+void gera_string(int nome) {
+    if (nome >= cap_constante_do_nome) {
+        int nova = cap_constante_do_nome ? cap_constante_do_nome : CONSTANTES_INICIAIS;
+        while (nova <= nome) nova *= 2;
+        int *mapa = realloc(constante_do_nome, nova * sizeof(int));
+        if (mapa == NULL) error("Memoria insuficiente para o codigo gerado.");
+        memset(mapa + cap_constante_do_nome, 0, (nova - cap_constante_do_nome) * sizeof(int));
+        constante_do_nome = mapa;
+        cap_constante_do_nome = nova;
     }
+    if (constante_do_nome[nome] == 0) {
+        cresce((void **)&codigo.constantes, codigo.num_constantes, &codigo.cap_constantes, sizeof(int), CONSTANTES_INICIAIS);
+        codigo.constantes[codigo.num_constantes++] = nome;
+        constante_do_nome[nome] = codigo.num_constantes;
+    }
+    nova_instrucao(OP_PUSH_STR)->arg.constante = constante_do_nome[nome] - 1;
+}
+
+// Gera uma instrução com um nome internado como operando; o texto só é buscado na impressão
+void gera_nome(OPCODE op, int nome) {
+    nova_instrucao(op)->arg.nome = nome;
+}
+
+void gera_vetor(OPCODE op, int base, int tamanho) {
+    INSTRUCAO *instrucao = nova_instrucao(op);
+    instrucao->arg.vetor.base = base;
+    instrucao->arg.vetor.tamanho = tamanho;
+}
+
+void gera_desvio(OPCODE op, int r) {
+    nova_instrucao(op)->arg.rotulo = r;
+}
+
+bool e_desvio(OPCODE op) {
+    return op == OP_GOTO || op == OP_GOFALSE || op == OP_GOTRUE || (op >= OP_JEQ && op <= OP_JGE);
 }
 
 // Retorna um novo número de rótulo
 int novo_rotulo() {
-    return contador_rotulo++;
+    return codigo.num_rotulos++;
 }
 
-// Gera um rótulo (ex: "L1:") como uma instrução
+// Gera um rótulo (LABEL Ln) como uma instrução
 void gera_rotulo(int r) {
-    char rotulo[TAM_LINHA];
-    snprintf(rotulo, sizeof(rotulo), "L%d:", r);
-    gera(rotulo);
+    nova_instrucao(OP_LABEL)->arg.rotulo = r;
+}
+
+void descarta_codigo_desde(int inicio) {
+    codigo.quantidade = inicio;
+    while (codigo.num_linhas > 0 && codigo.linhas[codigo.num_linhas - 1].instrucao >= inicio) codigo.num_linhas--;
+}
+
+INSTRUCAO *recorta_codigo_desde(int inicio, int *quantidade) {
+    *quantidade = codigo.quantidade - inicio;
+    INSTRUCAO *trecho = malloc((*quantidade + 1) * sizeof(INSTRUCAO));
+    if (trecho == NULL) error("Memoria insuficiente para o codigo gerado.");
+    memcpy(trecho, &codigo.instrucoes[inicio], *quantidade * sizeof(INSTRUCAO));
+    descarta_codigo_desde(inicio);
+    return trecho;
+}
+
+// As instruções voltam com a linha atual do fonte
+void gera_trecho(const INSTRUCAO *trecho, int quantidade) {
+    for (int i = 0; i < quantidade; i++) *nova_instrucao(trecho[i].op) = trecho[i];
+}
+
+// As globais ocupam o segmento de dados na ordem em que são declaradas
+int aloca_global(int celulas) {
+    int endereco = codigo.tam_dados;
+    codigo.tam_dados += celulas;
+    return endereco;
+}
+
+void inicia_quadro() {
+    tam_quadro_atual = 0;
+}
+
+int aloca_local(int celulas) {
+    int slot = tam_quadro_atual;
+    tam_quadro_atual += celulas;
+    return slot;
+}
+
+// As funções entram na ordem em que seus corpos são gerados
+void inicia_funcao(int nome, int num_params, bool com_retorno) {
+    cresce((void **)&codigo.funcoes, codigo.num_funcoes, &codigo.cap_funcoes, sizeof(FUNCAO_GERADA), CONSTANTES_INICIAIS);
+    codigo.funcoes[codigo.num_funcoes++] = (FUNCAO_GERADA){ nome, codigo.quantidade, num_params, com_retorno, 0 };
+}
+
+// Um corpo que chega ao '}' sem 'return' (ou vazio) não pode cair no código da função seguinte
+void termina_funcao() {
+    int inicio = codigo.funcoes[codigo.num_funcoes - 1].inicio;
+    codigo.funcoes[codigo.num_funcoes - 1].tam_quadro = tam_quadro_atual;
+    if (codigo.quantidade == inicio || codigo.instrucoes[codigo.quantidade - 1].op != OP_RET) gera(OP_RET);
+}
+
+// Escreve uma instrução no formato texto
+void imprime_instrucao(FILE *saida, const INSTRUCAO *instrucao) {
+    switch (instrucao->op) {
+        case OP_PUSH_INT: fprintf(saida, "PUSH %d", instrucao->arg.inteiro); break;
+        case OP_PUSH_REAL: fprintf(saida, "PUSH %f", instrucao->arg.real); break;
+        case OP_PUSH_CHAR: fprintf(saida, "PUSH '%c'", instrucao->arg.inteiro); break;
+        case OP_PUSH_STR: fprintf(saida, "PUSH \"%s\"", texto_nome(codigo.constantes[instrucao->arg.constante])); break;
+        case OP_GOFALSE: fprintf(saida, "GOFALSE L%d", instrucao->arg.rotulo); break;
+        case OP_GOTO: fprintf(saida, "GOTO L%d", instrucao->arg.rotulo); break;
+        case OP_LABEL: fprintf(saida, "LABEL L%d", instrucao->arg.rotulo); break;
+        case OP_CALL: fprintf(saida, "CALL %s", texto_nome(instrucao->arg.nome)); break;
+        case OP_RET: fputs("RET", saida); break;
+        case OP_NOT: fputs("NOT", saida); break;
+        case OP_EQ: fputs("EQ", saida); break;
+        case OP_NE: fputs("NE", saida); break;
+        case OP_LT: fputs("LT", saida); break;
+        case OP_GT: fputs("GT", saida); break;
+        case OP_LE: fputs("LE", saida); break;
+        case OP_GE: fputs("GE", saida); break;
+        case OP_AND: fputs("AND", saida); break;
+        case OP_OR: fputs("OR", saida); break;
+        case OP_LOAD_G: fprintf(saida, "LOAD_G %d", instrucao->arg.endereco); break;
+        case OP_LOAD_L: fprintf(saida, "LOAD_L %d", instrucao->arg.endereco); break;
+        case OP_STORE_G: fprintf(saida, "STORE_G %d", instrucao->arg.endereco); break;
+        case OP_STORE_L: fprintf(saida, "STORE_L %d", instrucao->arg.endereco); break;
+        case OP_LOAD_GX: fprintf(saida, "LOAD_GX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_LOAD_LX: fprintf(saida, "LOAD_LX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_STORE_GX: fprintf(saida, "STORE_GX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_STORE_LX: fprintf(saida, "STORE_LX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_FSTORE_G: fprintf(saida, "FSTORE_G %d", instrucao->arg.endereco); break;
+        case OP_FSTORE_L: fprintf(saida, "FSTORE_L %d", instrucao->arg.endereco); break;
+        case OP_FSTORE_GX: fprintf(saida, "FSTORE_GX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_FSTORE_LX: fprintf(saida, "FSTORE_LX %d %d", instrucao->arg.vetor.base, instrucao->arg.vetor.tamanho); break;
+        case OP_DUP: fputs("DUP", saida); break;
+        case OP_POP: fputs("POP", saida); break;
+        case OP_GOTRUE: fprintf(saida, "GOTRUE L%d", instrucao->arg.rotulo); break;
+        case OP_JEQ: fprintf(saida, "JEQ L%d", instrucao->arg.rotulo); break;
+        case OP_JNE: fprintf(saida, "JNE L%d", instrucao->arg.rotulo); break;
+        case OP_JLT: fprintf(saida, "JLT L%d", instrucao->arg.rotulo); break;
+        case OP_JGT: fprintf(saida, "JGT L%d", instrucao->arg.rotulo); break;
+        case OP_JLE: fprintf(saida, "JLE L%d", instrucao->arg.rotulo); break;
+        case OP_JGE: fprintf(saida, "JGE L%d", instrucao->arg.rotulo); break;
+        case OP_IADD: fputs("IADD", saida); break;
+        case OP_ISUB: fputs("ISUB", saida); break;
+        case OP_IMUL: fputs("IMUL", saida); break;
+        case OP_IDIV: fputs("IDIV", saida); break;
+        case OP_FADD: fputs("FADD", saida); break;
+        case OP_FSUB: fputs("FSUB", saida); break;
+        case OP_FMUL: fputs("FMUL", saida); break;
+        case OP_FDIV: fputs("FDIV", saida); break;
+        case OP_INEG: fputs("INEG", saida); break;
+        case OP_FNEG: fputs("FNEG", saida); break;
+        case OP_I2F: fputs("I2F", saida); break;
+        case OP_F2I: fputs("F2I", saida); break;
+        default: fprintf(saida, "?? (opcode %d)", instrucao->op); break;
+    }
 }
 
 // Salva as instruções da máquina de pilha em um arquivo .txt
@@ -42,11 +217,26 @@ void salvar_codigo_em_arquivo(const char *nome_arquivo) {
         perror("Erro ao abrir o arquivo para escrita");
         return;
     }
+    char *buffer = malloc(TAM_BUFFER_SAIDA);
+    if (buffer != NULL) setvbuf(arquivo, buffer, _IOFBF, TAM_BUFFER_SAIDA);
 
-    for (int i = 0; i < linha_atual; i++) {
-        fprintf(arquivo, "%s\n", codigo[i]);
+    for (int i = 0; i < codigo.quantidade; i++) {
+        imprime_instrucao(arquivo, &codigo.instrucoes[i]);
+        fputc('\n', arquivo);
     }
 
     fclose(arquivo);
+    free(buffer);
     printf("Código de máquina salvo em: %s\n", nome_arquivo);
 }
+
+// Esvazia as instruções, o pool de constantes, as funções e as linhas e zera os contadores de rótulos e de dados
+void limpar_codigo() {
+    for (int i = 0; i < codigo.num_constantes; i++) constante_do_nome[codigo.constantes[i]] = 0;
+    codigo.quantidade = 0;
+    codigo.num_constantes = 0;
+    codigo.num_funcoes = 0;
+    codigo.num_linhas = 0;
+    codigo.num_rotulos = 0;
+    codigo.tam_dados = 0;
+}
@@ -1,14 +1,187 @@
 #ifndef GERADOR_CODIGO_H
 #define GERADOR_CODIGO_H
 
-// Gera uma instrução de máquina de pilha com um parâmetro (pode ser vazio).
-void gera(char *instrucao);
+#include <stdio.h>
+#include <stdbool.h>
 
-// Retorna um número de rótulo único para os desvios (JMP, JMP_FALSE).
+// Operações da máquina de pilha. O texto de cada uma (ver imprime_instrucao) é o mesmo
+// que o gerador escrevia antes de guardar o código em registros binários.
+typedef enum {
+    OP_PUSH_INT,    // PUSH <inteiro>       operando: inteiro
+    OP_PUSH_REAL,   // PUSH <real>          operando: real
+    OP_PUSH_CHAR,   // PUSH '<c>'           operando: inteiro (o caractere)
+    OP_PUSH_STR,    // PUSH "<texto>"       operando: constante (índice no pool de strings)
+    OP_GOFALSE,     // GOFALSE L<n>         operando: rótulo
+    OP_GOTO,        // GOTO L<n>            operando: rótulo
+    OP_LABEL,       // LABEL L<n>           operando: rótulo
+    OP_CALL,        // CALL <função>        operando: nome
+    OP_RET,
+    OP_NOT,         // !x: 1 se x é zero, senão 0
+    OP_EQ,          // Relacionais: desempilham dois valores e empilham 1 ou 0
+    OP_NE,
+    OP_LT,
+    OP_GT,
+    OP_LE,
+    OP_GE,
+    OP_AND,         // Lógicos sobre dois valores já calculados: empilham 1 ou 0 (&& e || viram desvios)
+    OP_OR,
+    OP_LOAD_G,      // LOAD_G <índice>      operando: endereco (célula no segmento de dados)
+    OP_LOAD_L,      // LOAD_L <slot>        operando: endereco (célula no quadro da função)
+    OP_STORE_G,     // STORE_G <índice>     desempilha o valor e o guarda na célula, convertido para inteiro
+    OP_STORE_L,     // STORE_L <slot>
+    OP_LOAD_GX,     // LOAD_GX <base> <n>   operando: vetor; desempilha o índice e empilha o elemento
+    OP_LOAD_LX,     // LOAD_LX <base> <n>
+    OP_STORE_GX,    // STORE_GX <base> <n>  desempilha o índice e o valor e guarda o valor no elemento
+    OP_STORE_LX,    // STORE_LX <base> <n>
+    OP_FSTORE_G,    // FSTORE_G <índice>    como STORE_G, mas convertendo o valor para real
+    OP_FSTORE_L,    // FSTORE_L <slot>
+    OP_FSTORE_GX,   // FSTORE_GX <base> <n>
+    OP_FSTORE_LX,   // FSTORE_LX <base> <n>
+    OP_DUP,         // Duplica o topo (o valor de uma atribuição usada como expressão)
+    OP_POP,         // Descarta o topo (o valor de uma expressão usada como comando)
+    OP_GOTRUE,      // GOTRUE L<n>          operando: rótulo; desvia se o valor desempilhado não é zero
+    OP_JEQ,         // JEQ L<n>             Comparação e desvio: desempilham dois valores e desviam
+    OP_JNE,         //                      se a relação vale entre eles (ex: JLT = LT; GOTRUE)
+    OP_JLT,
+    OP_JGT,
+    OP_JLE,
+    OP_JGE,
+    OP_IADD,        // Aritmética tipada: os dois operandos são inteiros (IADD .. IDIV) ou reais
+    OP_ISUB,        // (FADD .. FDIV), o que o parser garante; a máquina não confere os tipos
+    OP_IMUL,
+    OP_IDIV,
+    OP_FADD,
+    OP_FSUB,
+    OP_FMUL,
+    OP_FDIV,
+    OP_INEG,        // -x de um inteiro
+    OP_FNEG,        // -x de um real
+    OP_I2F,         // Converte o inteiro do topo para real
+    OP_F2I,         // Converte o real do topo para inteiro (truncando; fora da faixa de int é erro)
+    NUM_OPCODES
+} OPCODE;
+
+// Uma instrução: o opcode e um operando de tamanho fixo, cujo campo depende do opcode.
+typedef struct {
+    OPCODE op;
+    union {
+        int inteiro;        // OP_PUSH_INT, OP_PUSH_CHAR
+        int nome;           // OP_CALL: código na Tabela de Nomes
+        int rotulo;         // OP_GOFALSE, OP_GOTRUE, OP_GOTO, OP_LABEL, OP_JEQ .. OP_JGE
+        int constante;      // OP_PUSH_STR: índice em codigo.constantes
+        int endereco;       // OP_LOAD_G, OP_LOAD_L, OP_STORE_G, OP_STORE_L, OP_FSTORE_G, OP_FSTORE_L
+        struct {
+            int base;       // Célula do elemento 0
+            int tamanho;    // Elementos (um vetor recebido como parâmetro não é indexado)
+        } vetor;            // OP_LOAD_GX, OP_LOAD_LX e os STOREs de elemento
+        double real;        // OP_PUSH_REAL
+    } arg;
+} INSTRUCAO;
+
+// Uma função cujo corpo foi gerado: onde o código dela começa e o tamanho do seu quadro.
+typedef struct {
+    int nome;           // Código do nome da função
+    int inicio;         // Índice da primeira instrução do corpo
+    int num_params;
+    bool com_retorno;   // false para funções void
+    int tam_quadro;     // Células do quadro: os parâmetros (slots 0 .. num_params-1) e depois as locais
+} FUNCAO_GERADA;
+
+// Tabela de linhas: a partir da instrução 'instrucao', o código veio da linha 'linha' do fonte.
+typedef struct {
+    int instrucao;
+    int linha;
+} LINHA_GERADA;
+
+// O código gerado: as instruções em ordem, o pool de constantes string, as funções e a tabela
+// de linhas, todos crescendo sob demanda. Fica exposto para que passes posteriores (otimização,
+// emissão binária, interpretação) trabalhem sobre ele.
+typedef struct {
+    INSTRUCAO *instrucoes;
+    int quantidade;
+    int capacidade;
+
+    int *constantes;        // Pool de strings: código do nome (texto internado) de cada constante
+    int num_constantes;
+    int cap_constantes;
+
+    FUNCAO_GERADA *funcoes;
+    int num_funcoes;
+    int cap_funcoes;
+
+    LINHA_GERADA *linhas;   // Uma entrada a cada mudança de linha, em ordem de instrução
+    int num_linhas;
+    int cap_linhas;
+
+    int num_rotulos;        // Rótulos já criados por novo_rotulo (L0 .. L{num_rotulos-1})
+    int tam_dados;          // Células do segmento de dados (as globais, vetores inteiros)
+} CODIGO;
+
+extern CODIGO codigo;
+
+// Gera uma instrução sem operando (aritméticas, conversões, RET, NOT, relacionais e lógicos).
+void gera(OPCODE op);
+
+// Gera uma instrução com operando inteiro (PUSH de inteiro ou de caractere).
+void gera_int(OPCODE op, int valor);
+
+// Gera um PUSH de constante real.
+void gera_real(double valor);
+
+// Gera um PUSH de constante string; o texto (já internado) entra no pool uma vez só.
+void gera_string(int nome);
+
+// Gera uma instrução cujo operando é um nome internado (ex: "PUSH x", "CALL soma").
+void gera_nome(OPCODE op, int nome);
+
+// Gera um acesso a um elemento de vetor (LOAD_GX, STORE_GX, ...): o índice já está no topo da pilha.
+void gera_vetor(OPCODE op, int base, int tamanho);
+
+// Gera um desvio (GOFALSE, GOTRUE, GOTO, JEQ .. JGE) para o rótulo r.
+void gera_desvio(OPCODE op, int r);
+
+// true para as instruções cujo operando é o rótulo de destino de um desvio (GOTO e os condicionais).
+bool e_desvio(OPCODE op);
+
+// Retorna um número de rótulo único para os desvios (GOTO, GOFALSE, GOTRUE).
 int novo_rotulo();
 
+// Marca a posição do rótulo r (instrução LABEL).
 void gera_rotulo(int r);
 
+// Descarta as instruções a partir da posição 'inicio' (o código de uma expressão que foi
+// substituída por outro, como uma constante dobrada). Não pode conter rótulos.
+void descarta_codigo_desde(int inicio);
+
+// Reserva 'celulas' células no segmento de dados para uma global; retorna o índice da primeira.
+int aloca_global(int celulas);
+
+// Começa o quadro de uma nova função: os próximos aloca_local contam a partir do slot 0.
+void inicia_quadro();
+
+// Reserva 'celulas' slots no quadro da função atual (parâmetros, na ordem, e depois as locais).
+int aloca_local(int celulas);
+
+// Retira do buffer as instruções a partir de 'inicio' e as devolve em um vetor alocado (com
+// *quantidade itens), para serem geradas de novo mais adiante com gera_trecho.
+INSTRUCAO *recorta_codigo_desde(int inicio, int *quantidade);
+
+// Gera de novo, no fim do buffer, um trecho retirado por recorta_codigo_desde.
+void gera_trecho(const INSTRUCAO *trecho, int quantidade);
+
+// Registra que o corpo da função 'nome' começa na próxima instrução.
+void inicia_funcao(int nome, int num_params, bool com_retorno);
+
+// Fecha o corpo da função aberta por inicia_funcao: se ele não termina em RET, gera um.
+// O quadro da função fica com os slots reservados desde inicia_quadro.
+void termina_funcao();
+
+// Escreve uma instrução no formato texto da máquina de pilha (sem o '\n').
+void imprime_instrucao(FILE *saida, const INSTRUCAO *instrucao);
+
 void salvar_codigo_em_arquivo(const char *nome_arquivo);
 
-#endif // GERADOR_CODIGO_H
\ No newline at end of file
+// Descarta as instruções geradas e recomeça a numeração dos rótulos (para compilar outro programa).
+void limpar_codigo();
+
+#endif // GERADOR_CODIGO_H
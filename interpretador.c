@@ -0,0 +1,641 @@
+/**
+ * @file interpretador.c
+ * @brief Implementação do interpretador da máquina de pilha.
+ *
+ * A imagem chega conferida por `carregar_imagem` ou `montar_imagem` (opcodes,
+ * desvios, índices e slots dentro dos limites); o laço de `executar_imagem` só
+ * confere o que depende dos valores: os limites das pilhas, a divisão por zero e,
+ * nas comparações, os tipos dos operandos.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "interpretador.h"
+#include "gerador_codigo.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(SEM_DESPACHO_DIRETO)
+#define DESPACHO_DIRETO
+#endif
+
+/** Um quadro da pilha de chamadas. */
+typedef struct {
+    int retorno;        ///< Instrução seguinte ao CALL (-1 na função de entrada).
+    int base;           ///< Topo da pilha de valores antes dos argumentos: o slot 0 do quadro.
+    int funcao;         ///< Símbolo da função chamada.
+} QUADRO;
+
+/** Uma célula que ainda não foi guardada: o inteiro 0, com os bytes do real 0.0. */
+static const VALOR ZERO = { VALOR_INT, { .real = 0.0 } };
+
+static double agora() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double como_real(const VALOR *valor) {
+    return valor->tipo == VALOR_REAL ? valor->v.real : (double)valor->v.inteiro;
+}
+
+static bool verdadeiro(const VALOR *valor) {
+    return valor->tipo == VALOR_REAL ? valor->v.real != 0.0 : valor->tipo == VALOR_STR || valor->v.inteiro != 0;
+}
+
+/** Converte o valor guardado por um STORE; devolve o motivo do erro, ou NULL. */
+static const char *para_inteiro(VALOR *valor) {
+    if (valor->tipo == VALOR_REAL) {
+        if (!(valor->v.real > -2147483649.0 && valor->v.real < 2147483648.0)) return "real fora da faixa de int em STORE";
+        valor->v.inteiro = (int32_t)valor->v.real;
+        valor->tipo = VALOR_INT;
+    } else if (valor->tipo == VALOR_STR) {
+        return "string guardada em variavel numerica";
+    }
+    return NULL;
+}
+
+/** Converte o valor guardado por um FSTORE; devolve o motivo do erro, ou NULL. */
+static const char *para_real(VALOR *valor) {
+    if (valor->tipo == VALOR_INT) {
+        valor->v.real = valor->v.inteiro;
+        valor->tipo = VALOR_REAL;
+    } else if (valor->tipo == VALOR_STR) {
+        return "string guardada em variavel numerica";
+    }
+    return NULL;
+}
+
+bool executar_imagem(const IMAGEM_CSB *imagem, const char *entrada, const OPCOES_EXECUCAO *opcoes,
+                     RESULTADO_EXECUCAO *resultado) {
+    memset(resultado, 0, sizeof(*resultado));
+    resultado->pc_erro = -1;
+
+    const CSB_CABECALHO *cab = imagem->cabecalho;
+    const CSB_INSTRUCAO *instrucoes = imagem->instrucoes;
+    const CSB_SIMBOLO *simbolos = imagem->simbolos;
+    int num_instrucoes = (int)cab->num_instrucoes;
+    int tam_pilha = opcoes && opcoes->tam_pilha > 0 ? opcoes->tam_pilha : PILHA_PADRAO;
+    int max_quadros = opcoes && opcoes->max_quadros > 0 ? opcoes->max_quadros : QUADROS_PADRAO;
+    long long max_instrucoes = opcoes ? opcoes->max_instrucoes : 0;
+
+    int inicio = -1, simbolo_entrada = -1;
+    for (uint32_t s = 0; s < cab->num_simbolos; s++) {
+        if (simbolos[s].tipo == CSB_FUNCAO && simbolos[s].endereco >= 0 && strcmp(nome_simbolo(imagem, s), entrada) == 0) {
+            inicio = simbolos[s].endereco;
+            simbolo_entrada = (int)s;
+        }
+    }
+    if (inicio < 0 || inicio >= num_instrucoes) {
+        snprintf(resultado->erro, sizeof(resultado->erro), "a funcao '%s' nao existe ou nao tem corpo", entrada);
+        return false;
+    }
+
+    // Tudo o que a execução usa é alocado aqui, uma vez
+    VALOR *pilha = malloc((size_t)tam_pilha * sizeof(VALOR));
+    QUADRO *quadros = malloc((size_t)max_quadros * sizeof(QUADRO));
+    VALOR *dados = calloc((size_t)cab->tam_dados + 1, sizeof(VALOR));
+#ifdef DESPACHO_DIRETO
+    const void **despacho = malloc(((size_t)num_instrucoes + 1) * sizeof(void *));
+#endif
+    if (pilha == NULL || quadros == NULL || dados == NULL
+#ifdef DESPACHO_DIRETO
+        || despacho == NULL
+#endif
+    ) {
+        snprintf(resultado->erro, sizeof(resultado->erro), "memoria insuficiente para a execucao");
+        free(pilha); free(quadros); free(dados);
+#ifdef DESPACHO_DIRETO
+        free(despacho);
+#endif
+        return false;
+    }
+
+#ifdef DESPACHO_DIRETO
+    static const void *const tratadores[NUM_OPCODES] = {
+        [OP_PUSH_INT] = &&op_PUSH_INT, [OP_PUSH_REAL] = &&op_PUSH_REAL, [OP_PUSH_CHAR] = &&op_PUSH_CHAR,
+        [OP_PUSH_STR] = &&op_PUSH_STR,
+        [OP_GOFALSE] = &&op_GOFALSE, [OP_GOTO] = &&op_GOTO, [OP_LABEL] = &&op_LABEL,
+        [OP_CALL] = &&op_CALL, [OP_RET] = &&op_RET,
+        [OP_NOT] = &&op_NOT,
+        [OP_EQ] = &&op_EQ, [OP_NE] = &&op_NE, [OP_LT] = &&op_LT, [OP_GT] = &&op_GT, [OP_LE] = &&op_LE, [OP_GE] = &&op_GE,
+        [OP_AND] = &&op_AND, [OP_OR] = &&op_OR,
+        [OP_LOAD_G] = &&op_LOAD_G, [OP_LOAD_L] = &&op_LOAD_L, [OP_STORE_G] = &&op_STORE_G, [OP_STORE_L] = &&op_STORE_L,
+        [OP_LOAD_GX] = &&op_LOAD_GX, [OP_LOAD_LX] = &&op_LOAD_LX,
+        [OP_STORE_GX] = &&op_STORE_GX, [OP_STORE_LX] = &&op_STORE_LX,
+        [OP_FSTORE_G] = &&op_FSTORE_G, [OP_FSTORE_L] = &&op_FSTORE_L,
+        [OP_FSTORE_GX] = &&op_FSTORE_GX, [OP_FSTORE_LX] = &&op_FSTORE_LX,
+        [OP_DUP] = &&op_DUP, [OP_POP] = &&op_POP, [OP_GOTRUE] = &&op_GOTRUE,
+        [OP_JEQ] = &&op_JEQ, [OP_JNE] = &&op_JNE, [OP_JLT] = &&op_JLT, [OP_JGT] = &&op_JGT,
+        [OP_JLE] = &&op_JLE, [OP_JGE] = &&op_JGE,
+        [OP_IADD] = &&op_IADD, [OP_ISUB] = &&op_ISUB, [OP_IMUL] = &&op_IMUL, [OP_IDIV] = &&op_IDIV,
+        [OP_FADD] = &&op_FADD, [OP_FSUB] = &&op_FSUB, [OP_FMUL] = &&op_FMUL, [OP_FDIV] = &&op_FDIV,
+        [OP_INEG] = &&op_INEG, [OP_FNEG] = &&op_FNEG, [OP_I2F] = &&op_I2F, [OP_F2I] = &&op_F2I,
+    };
+    for (int i = 0; i < num_instrucoes; i++) despacho[i] = tratadores[instrucoes[i].op];
+    despacho[num_instrucoes] = &&fim_do_codigo; // Sentinela: cair do fim do código é um erro
+#define INSTRUCAO(op) op_##op:
+#define PROXIMA() do { executadas++; goto *despacho[pc]; } while (0)
+#else
+#define INSTRUCAO(op) case OP_##op:
+#define PROXIMA() do { executadas++; goto proxima; } while (0)
+#endif
+
+// Sobe o pc a partir de um desvio; os laços passam por aqui, então é aqui que o limite é conferido
+#define DESVIA(alvo) do {                                                        \
+        pc = (alvo) + 1; /* O destino é o LABEL, que não faz nada */            \
+        if (max_instrucoes && executadas >= max_instrucoes) goto limite;         \
+    } while (0)
+
+#define EMPILHA_CHECA() do { if (__builtin_expect(sp == tam_pilha, 0)) goto pilha_cheia; } while (0)
+
+// Aritmética tipada: os operandos já são do tipo da instrução (o parser garante), então não há
+// o que conferir além da pilha. Uma célula real que nunca foi guardada vale 0 como inteiro,
+// mas os seus bytes são os do real 0.0; por isso o resultado real sempre recebe o seu tipo.
+#define ARITMETICA_INTEIRA(operador) do {                                                         \
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;                                        \
+        VALOR *b = &pilha[--sp], *a = &pilha[sp - 1];                                             \
+        a->v.inteiro = (int32_t)((uint32_t)a->v.inteiro operador (uint32_t)b->v.inteiro);         \
+        pc++;                                                                                     \
+    } while (0)
+
+#define ARITMETICA_REAL(operador) do {                                                            \
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;                                        \
+        VALOR *b = &pilha[--sp], *a = &pilha[sp - 1];                                             \
+        a->v.real = a->v.real operador b->v.real;                                                 \
+        a->tipo = VALOR_REAL;                                                                     \
+        pc++;                                                                                     \
+    } while (0)
+
+#define COMPARACAO(operador, nome_op) do {                                                        \
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;                                        \
+        VALOR *b = &pilha[--sp], *a = &pilha[sp - 1];                                             \
+        if (a->tipo == VALOR_INT && b->tipo == VALOR_INT) {                                       \
+            a->v.inteiro = a->v.inteiro operador b->v.inteiro;                                    \
+        } else if (a->tipo == VALOR_STR || b->tipo == VALOR_STR) {                                \
+            motivo = "operando string em " nome_op;                                               \
+            goto erro;                                                                            \
+        } else {                                                                                  \
+            a->v.inteiro = como_real(a) operador como_real(b);                                    \
+            a->tipo = VALOR_INT;                                                                  \
+        }                                                                                         \
+        pc++;                                                                                     \
+    } while (0)
+
+// Confere o índice do topo contra o vetor da instrução e põe em 'celula' a posição do elemento
+#define CONFERE_INDICE(celula) do {                                                               \
+        const VALOR *indice = &pilha[sp - 1];                                                     \
+        int tamanho = instrucoes[pc].arg.vetor.tamanho;                                           \
+        if (indice->tipo != VALOR_INT) {                                                          \
+            motivo = "indice de vetor nao inteiro";                                               \
+            goto erro;                                                                            \
+        }                                                                                         \
+        if (indice->v.inteiro < 0 || indice->v.inteiro >= tamanho) {                              \
+            motivo = "indice fora dos limites do vetor";                                          \
+            goto erro;                                                                            \
+        }                                                                                         \
+        celula = instrucoes[pc].arg.vetor.base + indice->v.inteiro;                               \
+    } while (0)
+
+// Troca o índice do topo pelo elemento do vetor que começa em celulas[base]
+#define ELEMENTO(celulas) do {                                                                    \
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;                                        \
+        int celula;                                                                               \
+        CONFERE_INDICE(celula);                                                                   \
+        pilha[sp - 1] = (celulas)[celula];                                                        \
+        pc++;                                                                                     \
+    } while (0)
+
+// Desempilha um valor, converte com 'conversao' (para_inteiro ou para_real) e o guarda em 'destino'
+#define GUARDA(destino, conversao) do {                                                           \
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;                                        \
+        VALOR *valor = &pilha[--sp];                                                              \
+        if (__builtin_expect((motivo = conversao(valor)) != NULL, 0)) goto erro;                  \
+        destino = *valor;                                                                         \
+        pc++;                                                                                     \
+    } while (0)
+
+// Desempilha o índice e o valor abaixo dele e guarda o valor no elemento do vetor
+#define GUARDA_ELEMENTO(celulas, conversao) do {                                                  \
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;                                        \
+        int celula;                                                                               \
+        CONFERE_INDICE(celula);                                                                   \
+        sp--;                                                                                     \
+        GUARDA((celulas)[celula], conversao);                                                     \
+    } while (0)
+
+// Comparação e desvio: desempilha os dois operandos e desvia se 'a operador b'. Entre reais, o
+// desvio é tomado quando 'a inverso b' não vale, o que também inclui um NaN: JGE é o que sobra
+// de 'LT; GOFALSE' e tem de desviar quando LT empilharia 0.
+#define DESVIO_COMPARACAO(operador, inverso, nome_op) do {                                        \
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;                                        \
+        const VALOR *b = &pilha[sp - 1], *a = &pilha[sp - 2];                                     \
+        bool vale;                                                                                \
+        if (a->tipo == VALOR_INT && b->tipo == VALOR_INT) {                                       \
+            vale = a->v.inteiro operador b->v.inteiro;                                            \
+        } else if (a->tipo == VALOR_STR || b->tipo == VALOR_STR) {                                \
+            motivo = "operando string em " nome_op;                                               \
+            goto erro;                                                                            \
+        } else {                                                                                  \
+            vale = !(como_real(a) inverso como_real(b));                                          \
+        }                                                                                         \
+        sp -= 2;                                                                                  \
+        if (vale) DESVIA(instrucoes[pc].arg.inteiro);                                             \
+        else pc++;                                                                                \
+    } while (0)
+
+#define LOGICA(operador) do {                                                                     \
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;                                        \
+        VALOR *b = &pilha[--sp], *a = &pilha[sp - 1];                                             \
+        a->v.inteiro = verdadeiro(a) operador verdadeiro(b);                                      \
+        a->tipo = VALOR_INT;                                                                      \
+        pc++;                                                                                     \
+    } while (0)
+
+    int pc = inicio, sp = 0, nq = 0;
+    int bp = 0; // Base do quadro atual: os slots de LOAD_L/STORE_L
+    long long executadas = 0;
+    const char *motivo = NULL;
+    quadros[nq++] = (QUADRO){ -1, 0, simbolo_entrada };
+    resultado->pico_quadros = 1;
+    double t0 = agora();
+    if (simbolos[simbolo_entrada].tam_quadro > (uint32_t)tam_pilha) goto pilha_cheia;
+    memset(pilha, 0, simbolos[simbolo_entrada].tam_quadro * sizeof(VALOR));
+    sp = (int)simbolos[simbolo_entrada].tam_quadro;
+
+#ifdef DESPACHO_DIRETO
+    goto *despacho[pc];
+#else
+proxima:
+    if (__builtin_expect(pc >= num_instrucoes, 0)) goto fim_do_codigo;
+    switch (instrucoes[pc].op) {
+#endif
+
+    INSTRUCAO(PUSH_INT)
+    INSTRUCAO(PUSH_CHAR)
+        EMPILHA_CHECA();
+        pilha[sp].tipo = VALOR_INT;
+        pilha[sp++].v.inteiro = instrucoes[pc++].arg.inteiro;
+        PROXIMA();
+
+    INSTRUCAO(PUSH_REAL)
+        EMPILHA_CHECA();
+        pilha[sp].tipo = VALOR_REAL;
+        pilha[sp++].v.real = instrucoes[pc++].arg.real;
+        PROXIMA();
+
+    INSTRUCAO(PUSH_STR)
+        EMPILHA_CHECA();
+        pilha[sp].tipo = VALOR_STR;
+        pilha[sp++].v.constante = instrucoes[pc++].arg.inteiro;
+        PROXIMA();
+
+    INSTRUCAO(LOAD_G)
+        EMPILHA_CHECA();
+        pilha[sp++] = dados[instrucoes[pc++].arg.inteiro];
+        PROXIMA();
+
+    INSTRUCAO(LOAD_L)
+        EMPILHA_CHECA();
+        pilha[sp++] = pilha[bp + instrucoes[pc++].arg.inteiro];
+        PROXIMA();
+
+    INSTRUCAO(STORE_G)
+        GUARDA(dados[instrucoes[pc].arg.inteiro], para_inteiro);
+        PROXIMA();
+
+    INSTRUCAO(STORE_L)
+        GUARDA(pilha[bp + instrucoes[pc].arg.inteiro], para_inteiro);
+        PROXIMA();
+
+    INSTRUCAO(FSTORE_G)
+        GUARDA(dados[instrucoes[pc].arg.inteiro], para_real);
+        PROXIMA();
+
+    INSTRUCAO(FSTORE_L)
+        GUARDA(pilha[bp + instrucoes[pc].arg.inteiro], para_real);
+        PROXIMA();
+
+    INSTRUCAO(LOAD_GX)
+        ELEMENTO(dados);
+        PROXIMA();
+
+    INSTRUCAO(LOAD_LX)
+        ELEMENTO(pilha + bp);
+        PROXIMA();
+
+    INSTRUCAO(STORE_GX)
+        GUARDA_ELEMENTO(dados, para_inteiro);
+        PROXIMA();
+
+    INSTRUCAO(STORE_LX)
+        GUARDA_ELEMENTO(pilha + bp, para_inteiro);
+        PROXIMA();
+
+    INSTRUCAO(FSTORE_GX)
+        GUARDA_ELEMENTO(dados, para_real);
+        PROXIMA();
+
+    INSTRUCAO(FSTORE_LX)
+        GUARDA_ELEMENTO(pilha + bp, para_real);
+        PROXIMA();
+
+    INSTRUCAO(DUP)
+        EMPILHA_CHECA();
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        pilha[sp] = pilha[sp - 1];
+        sp++;
+        pc++;
+        PROXIMA();
+
+    INSTRUCAO(POP)
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        sp--;
+        pc++;
+        PROXIMA();
+
+    INSTRUCAO(IADD)
+        ARITMETICA_INTEIRA(+);
+        PROXIMA();
+
+    INSTRUCAO(ISUB)
+        ARITMETICA_INTEIRA(-);
+        PROXIMA();
+
+    INSTRUCAO(IMUL)
+        ARITMETICA_INTEIRA(*);
+        PROXIMA();
+
+    INSTRUCAO(IDIV) {
+        if (__builtin_expect(sp < 2, 0)) goto pilha_vazia;
+        VALOR *b = &pilha[--sp], *a = &pilha[sp - 1];
+        if (b->v.inteiro == 0) {
+            motivo = "divisao inteira por zero";
+            goto erro;
+        }
+        // INT_MIN / -1 não cabe em um int: dá a volta, como IADD, ISUB e IMUL
+        a->v.inteiro = b->v.inteiro == -1 ? (int32_t)(0u - (uint32_t)a->v.inteiro) : a->v.inteiro / b->v.inteiro;
+        pc++;
+        PROXIMA();
+    }
+
+    INSTRUCAO(FADD)
+        ARITMETICA_REAL(+);
+        PROXIMA();
+
+    INSTRUCAO(FSUB)
+        ARITMETICA_REAL(-);
+        PROXIMA();
+
+    INSTRUCAO(FMUL)
+        ARITMETICA_REAL(*);
+        PROXIMA();
+
+    INSTRUCAO(FDIV)
+        ARITMETICA_REAL(/);
+        PROXIMA();
+
+    INSTRUCAO(INEG)
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        pilha[sp - 1].v.inteiro = (int32_t)(0u - (uint32_t)pilha[sp - 1].v.inteiro);
+        pc++;
+        PROXIMA();
+
+    INSTRUCAO(FNEG)
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        pilha[sp - 1].v.real = -pilha[sp - 1].v.real;
+        pilha[sp - 1].tipo = VALOR_REAL;
+        pc++;
+        PROXIMA();
+
+    INSTRUCAO(I2F) {
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        VALOR *a = &pilha[sp - 1];
+        a->v.real = a->v.inteiro;
+        a->tipo = VALOR_REAL;
+        pc++;
+        PROXIMA();
+    }
+
+    INSTRUCAO(F2I) {
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        VALOR *a = &pilha[sp - 1];
+        if (!(a->v.real > -2147483649.0 && a->v.real < 2147483648.0)) {
+            motivo = "real fora da faixa de int em F2I";
+            goto erro;
+        }
+        a->v.inteiro = (int32_t)a->v.real;
+        a->tipo = VALOR_INT;
+        pc++;
+        PROXIMA();
+    }
+
+    INSTRUCAO(NOT) {
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        VALOR *a = &pilha[sp - 1];
+        a->v.inteiro = !verdadeiro(a);
+        a->tipo = VALOR_INT;
+        pc++;
+        PROXIMA();
+    }
+
+    INSTRUCAO(EQ)
+        COMPARACAO(==, "EQ");
+        PROXIMA();
+
+    INSTRUCAO(NE)
+        COMPARACAO(!=, "NE");
+        PROXIMA();
+
+    INSTRUCAO(LT)
+        COMPARACAO(<, "LT");
+        PROXIMA();
+
+    INSTRUCAO(GT)
+        COMPARACAO(>, "GT");
+        PROXIMA();
+
+    INSTRUCAO(LE)
+        COMPARACAO(<=, "LE");
+        PROXIMA();
+
+    INSTRUCAO(GE)
+        COMPARACAO(>=, "GE");
+        PROXIMA();
+
+    INSTRUCAO(AND)
+        LOGICA(&&);
+        PROXIMA();
+
+    INSTRUCAO(OR)
+        LOGICA(||);
+        PROXIMA();
+
+    INSTRUCAO(GOFALSE) {
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        const VALOR *condicao = &pilha[--sp];
+        if (!verdadeiro(condicao)) DESVIA(instrucoes[pc].arg.inteiro);
+        else pc++;
+        PROXIMA();
+    }
+
+    INSTRUCAO(GOTRUE) {
+        if (__builtin_expect(sp < 1, 0)) goto pilha_vazia;
+        const VALOR *condicao = &pilha[--sp];
+        if (verdadeiro(condicao)) DESVIA(instrucoes[pc].arg.inteiro);
+        else pc++;
+        PROXIMA();
+    }
+
+    INSTRUCAO(JEQ)
+        DESVIO_COMPARACAO(==, !=, "JEQ");
+        PROXIMA();
+
+    INSTRUCAO(JNE)
+        DESVIO_COMPARACAO(!=, ==, "JNE");
+        PROXIMA();
+
+    INSTRUCAO(JLT)
+        DESVIO_COMPARACAO(<, >=, "JLT");
+        PROXIMA();
+
+    INSTRUCAO(JGT)
+        DESVIO_COMPARACAO(>, <=, "JGT");
+        PROXIMA();
+
+    INSTRUCAO(JLE)
+        DESVIO_COMPARACAO(<=, >, "JLE");
+        PROXIMA();
+
+    INSTRUCAO(JGE)
+        DESVIO_COMPARACAO(>=, <, "JGE");
+        PROXIMA();
+
+    INSTRUCAO(GOTO)
+        DESVIA(instrucoes[pc].arg.inteiro);
+        PROXIMA();
+
+    INSTRUCAO(LABEL)
+        pc++;
+        PROXIMA();
+
+    INSTRUCAO(CALL) {
+        int funcao = instrucoes[pc].arg.inteiro;
+        const CSB_SIMBOLO *simbolo = &simbolos[funcao];
+        if (simbolo->endereco < 0) {
+            motivo = "chamada de funcao sem corpo";
+            goto erro;
+        }
+        if (__builtin_expect(nq == max_quadros, 0)) {
+            motivo = "chamadas aninhadas demais";
+            goto erro;
+        }
+        if (__builtin_expect(sp < (int)simbolo->num_params, 0)) goto pilha_vazia;
+        bp = sp - (int)simbolo->num_params;
+        if (__builtin_expect(simbolo->tam_quadro > (uint32_t)(tam_pilha - bp), 0)) goto pilha_cheia;
+        quadros[nq++] = (QUADRO){ pc + 1, bp, funcao };
+        if (nq > resultado->pico_quadros) resultado->pico_quadros = nq;
+        while (sp < bp + (int)simbolo->tam_quadro) pilha[sp++] = ZERO; // As locais começam em 0
+        DESVIA(simbolo->endereco - 1);
+        PROXIMA();
+    }
+
+    INSTRUCAO(RET) {
+        QUADRO *quadro = &quadros[--nq];
+        const CSB_SIMBOLO *simbolo = &simbolos[quadro->funcao];
+        if (simbolo->com_retorno) {
+            VALOR valor = sp > quadro->base + (int)simbolo->tam_quadro ? pilha[sp - 1] : ZERO;
+            sp = quadro->base;
+            pilha[sp++] = valor; // Cabe: a base está abaixo de onde o valor estava
+        } else {
+            sp = quadro->base;
+        }
+        if (nq == 0) goto terminou;
+        bp = quadros[nq - 1].base;
+        pc = quadro->retorno;
+        PROXIMA();
+    }
+
+#ifndef DESPACHO_DIRETO
+    }
+#endif
+
+fim_do_codigo:
+    motivo = "a execucao passou do fim do codigo";
+    goto erro;
+pilha_cheia:
+    motivo = "pilha de execucao cheia";
+    goto erro;
+pilha_vazia:
+    motivo = "pilha de execucao vazia";
+    goto erro;
+limite:
+    motivo = "limite de instrucoes atingido";
+erro:
+    resultado->ok = false;
+    resultado->pc_erro = pc;
+    resultado->linha_erro = pc < num_instrucoes ? linha_da_instrucao(imagem, pc) : 0;
+    snprintf(resultado->erro, sizeof(resultado->erro), "%s", motivo);
+    goto fim;
+terminou:
+    resultado->ok = true;
+    resultado->tem_retorno = simbolos[simbolo_entrada].com_retorno != 0;
+    if (resultado->tem_retorno) resultado->retorno = pilha[0];
+fim:
+    resultado->segundos = agora() - t0;
+    resultado->instrucoes = executadas + 1; // O RET final (ou a instrução do erro) não passou por PROXIMA
+    free(pilha);
+    free(quadros);
+    free(dados);
+#ifdef DESPACHO_DIRETO
+    free(despacho);
+#endif
+    return resultado->ok;
+
+#undef INSTRUCAO
+#undef PROXIMA
+#undef DESVIA
+#undef EMPILHA_CHECA
+#undef ARITMETICA_INTEIRA
+#undef ARITMETICA_REAL
+#undef COMPARACAO
+#undef CONFERE_INDICE
+#undef ELEMENTO
+#undef GUARDA
+#undef GUARDA_ELEMENTO
+#undef DESVIO_COMPARACAO
+#undef LOGICA
+}
+
+void imprime_valor(FILE *saida, const IMAGEM_CSB *imagem, const VALOR *valor) {
+    switch (valor->tipo) {
+        case VALOR_INT: fprintf(saida, "%d", valor->v.inteiro); break;
+        case VALOR_REAL: fprintf(saida, "%f", valor->v.real); break;
+        case VALOR_STR: fprintf(saida, "\"%s\"", imagem->textos + imagem->constantes[valor->v.constante].off_texto); break;
+        default: fprintf(saida, "?? (tipo %d)", valor->tipo); break;
+    }
+}
+
+void relatorio_execucao(FILE *saida, const IMAGEM_CSB *imagem, const RESULTADO_EXECUCAO *resultado) {
+    fprintf(saida, "\n=== Execucao ===\n");
+    if (!resultado->ok) {
+        fprintf(saida, "Erro de execucao");
+        if (resultado->linha_erro > 0) fprintf(saida, " na linha %d", resultado->linha_erro);
+        if (resultado->pc_erro >= 0) fprintf(saida, " (instrucao %d)", resultado->pc_erro);
+        fprintf(saida, ": %s\n", resultado->erro);
+    } else if (resultado->tem_retorno) {
+        fprintf(saida, "Valor de retorno: ");
+        imprime_valor(saida, imagem, &resultado->retorno);
+        fputc('\n', saida);
+    } else {
+        fprintf(saida, "Execucao concluida.\n");
+    }
+    fprintf(saida, "Instrucoes executadas: %lld\n", resultado->instrucoes);
+    fprintf(saida, "Tempo: %.6f s\n", resultado->segundos);
+    if (resultado->segundos > 0) fprintf(saida, "Instrucoes/s: %.0f\n", resultado->instrucoes / resultado->segundos);
+    fprintf(saida, "Pico de chamadas aninhadas: %d\n", resultado->pico_quadros);
+#ifdef DESPACHO_DIRETO
+    fprintf(saida, "Despacho: direto (computed goto)\n");
+#else
+    fprintf(saida, "Despacho: switch\n");
+#endif
+}
@@ -0,0 +1,107 @@
+/**
+ * @file interpretador.h
+ * @brief Interpretador da máquina de pilha: executa uma imagem .csb (ver bytecode.h).
+ *
+ * O laço principal usa despacho direto (computed goto do GCC/Clang): antes de
+ * começar, cada instrução ganha o endereço do seu tratador, e cada tratador salta
+ * direto para o da instrução seguinte. Em outros compiladores, ou compilando com
+ * `-DSEM_DESPACHO_DIRETO`, o mesmo laço vira um `switch`.
+ *
+ * A pilha de valores e a pilha de chamadas são alocadas uma vez, no início da
+ * execução, com tamanho fixo; nenhuma instrução nem chamada aloca memória.
+ *
+ * Semântica das instruções:
+ * - PUSH empilha uma constante; LOAD_G e LOAD_L empilham uma célula do segmento de
+ *   dados (as globais) ou do quadro da função (parâmetros e locais), e STORE_G e
+ *   STORE_L desempilham um valor para ela, convertido para inteiro (FSTORE_G e
+ *   FSTORE_L convertem para real; um real fora da faixa de int ou uma string é erro
+ *   de execução); LOAD_GX e LOAD_LX trocam o índice do topo pelo elemento do vetor,
+ *   e STORE_GX etc. desempilham o índice e o valor abaixo dele (índice fora dos
+ *   limites é erro de execução). Toda célula começa em 0 (cujos bytes são os do real 0.0);
+ * - DUP duplica o topo; POP o descarta;
+ * - IADD, ISUB, IMUL, IDIV desempilham dois inteiros e empilham o resultado (que dá a
+ *   volta em 32 bits; dividir por zero é erro de execução), FADD, FSUB, FMUL, FDIV fazem
+ *   o mesmo com dois reais, e INEG e FNEG trocam o sinal do topo. Essas instruções não
+ *   conferem os tipos: o parser só as gera com operandos do tipo certo, convertendo com
+ *   I2F (inteiro para real) ou F2I (real para inteiro, truncando; fora da faixa de int é
+ *   erro de execução) onde os tipos se misturam;
+ * - EQ, NE, LT, GT, LE, GE comparam dois números e empilham 1 ou 0; NOT, AND e OR
+ *   empilham 1 ou 0 conforme os operandos sejam verdadeiros (diferentes de zero; uma
+ *   string é sempre verdadeira);
+ * - GOFALSE desempilha um valor e desvia se ele é zero, GOTRUE se ele não é; GOTO
+ *   sempre desvia; JEQ, JNE, JLT, JGT, JLE, JGE comparam dois números como EQ etc. e
+ *   desviam se a relação vale. Um operando real NaN não é ordenado: JLT, JGT, JLE e JGE
+ *   também desviam nesse caso (JGE é 'LT; GOFALSE'). O parser só funde comparações
+ *   entre inteiros, e então inverte um desvio fundido trocando a relação;
+ * - CALL abre um quadro cuja base fica abaixo dos argumentos já empilhados (que viram
+ *   os slots 0 .. num_params-1) e reserva acima deles os slots das locais;
+ * - RET descarta o quadro (argumentos, locais e o que sobrou na pilha) e, se a função
+ *   não é void, deixa o valor do topo (ou 0, se não havia nada acima das locais) como
+ *   resultado.
+ */
+
+#ifndef _INTERPRETADOR_
+#define _INTERPRETADOR_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bytecode.h"
+
+#define PILHA_PADRAO (64 * 1024)    ///< Valores na pilha de execução.
+#define QUADROS_PADRAO 4096         ///< Chamadas aninhadas.
+
+/** @brief Tipo de um valor da máquina. */
+typedef enum {
+    VALOR_INT,      ///< Inteiro (também os caracteres); o zero de VALOR é o inteiro 0.
+    VALOR_REAL,
+    VALOR_STR       ///< Índice de uma constante string da imagem.
+} TIPO_VALOR;
+
+/** @brief Um valor na pilha ou em uma variável. */
+typedef struct {
+    int32_t tipo;           ///< Um TIPO_VALOR.
+    union {
+        int32_t inteiro;
+        int32_t constante;
+        double real;
+    } v;
+} VALOR;
+
+/** @brief Limites de uma execução. */
+typedef struct {
+    int tam_pilha;              ///< Valores na pilha (0 = PILHA_PADRAO).
+    int max_quadros;            ///< Chamadas aninhadas (0 = QUADROS_PADRAO).
+    long long max_instrucoes;   ///< Interrompe laços infinitos (0 = sem limite).
+} OPCOES_EXECUCAO;
+
+/** @brief O que aconteceu em uma execução. */
+typedef struct {
+    bool ok;                    ///< false se a execução parou com um erro.
+    char erro[160];             ///< A mensagem de erro (quando !ok).
+    int pc_erro;                ///< Instrução onde o erro aconteceu.
+    int linha_erro;             ///< Linha do fonte dessa instrução (0 se a imagem não tem tabela de linhas).
+
+    bool tem_retorno;           ///< A função de entrada devolveu um valor.
+    VALOR retorno;
+
+    long long instrucoes;       ///< Instruções executadas.
+    double segundos;            ///< Tempo do laço de execução.
+    int pico_quadros;           ///< Maior profundidade de chamadas.
+} RESULTADO_EXECUCAO;
+
+/**
+ * @brief Executa a função `entrada` da imagem até ela retornar.
+ * @param opcoes Limites da execução, ou NULL para os padrões.
+ * @return resultado->ok.
+ */
+bool executar_imagem(const IMAGEM_CSB *imagem, const char *entrada, const OPCOES_EXECUCAO *opcoes,
+                     RESULTADO_EXECUCAO *resultado);
+
+/** @brief Escreve um valor ("42", "2.500000", "\"texto\""). */
+void imprime_valor(FILE *saida, const IMAGEM_CSB *imagem, const VALOR *valor);
+
+/** @brief Escreve o resultado da execução: o retorno ou o erro, instruções executadas e instruções/s. */
+void relatorio_execucao(FILE *saida, const IMAGEM_CSB *imagem, const RESULTADO_EXECUCAO *resultado);
+
+#endif // _INTERPRETADOR_
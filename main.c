@@ -4,33 +4,216 @@
 #include "anasint.h"
 #include "tabela_simbolos.h"
 #include "gerador_codigo.h"
+#include "rastro.h"
+#include "bytecode.h"
+#include "interpretador.h"
+#include "otimizador.h"
 
 // --- Variáveis Globais Definidas Aqui ---
 TOKEN t;
 FILE *fd;
 int contLinha = 1;
-char TABS[200] = ""; // Variável para controlar a indentação da árvore
 
-void main()
+/*
+    Uso: analisador_cshort [--pre-analex] [--threads N] [--rastro NIVEL] [--rastro-saida ARQ] [--rastro-anel KB] [--estatisticas]
+                           [--log-tabela ARQ] [--instantaneos-tabela ARQ] [--tabela-passo-a-passo] [--sem-otimizacao] [--sem-regra NOME]
+                           [--csb ARQ] [--csb-sem-linhas] [--executar] [--pilha N] [--max-instrucoes N] [arquivo]
+           analisador_cshort --regras-peephole
+           analisador_cshort --desmontar ARQ.csb | --desmontar-detalhado ARQ.csb
+           analisador_cshort [--pilha N] [--max-instrucoes N] --executar-csb ARQ.csb
+        --pre-analex    lê o arquivo inteiro em um fluxo de tokens antes de começar o parser
+        --threads N     como --pre-analex, lendo trechos do arquivo em N threads (arquivos grandes)
+        --rastro NIVEL  desligado (padrão), tokens (os tokens consumidos) ou arvore (a árvore sintática)
+        --rastro-saida  escreve o rastro em ARQ em vez da saída padrão
+        --rastro-anel   guarda só os últimos KB do rastro e os escreve no fim (ou quando há erro)
+        --estatisticas  no fim, mostra o pico de entradas e a memória da tabela de símbolos e o que o otimizador fez
+        --log-tabela    registra em ARQ cada evento da tabela de símbolos (inserir, sombrear, matar, retirar)
+        --instantaneos-tabela  grava em ARQ a tabela inteira no fim de cada função e do programa (JSON Lines)
+        --tabela-passo-a-passo imprime a tabela a cada evento e espera um Enter (depuração interativa)
+        --sem-otimizacao  salva o código como o parser o gerou, sem o peephole e o encadeamento de desvios
+        --sem-regra     desliga uma regra do peephole (pode ser repetida)
+        --regras-peephole  lista as regras do peephole e termina
+        --csb           grava também a imagem binária do código em ARQ (ver bytecode.h)
+        --csb-sem-linhas  omite da imagem a tabela de linhas do fonte
+        --desmontar     só imprime o texto de uma imagem .csb (o mesmo de codigo_maquina.txt) e termina
+        --desmontar-detalhado  como --desmontar, com o índice de cada instrução, as funções e as linhas
+        --executar      depois de compilar, executa a função main e mostra o retorno e as instruções/s
+        --executar-csb  só executa a função main de uma imagem .csb já gravada e termina
+        --pilha N       tamanho da pilha de execução, em valores (padrão: 65536)
+        --max-instrucoes N  interrompe a execução depois de N instruções (padrão: sem limite)
+        arquivo         código-fonte a ser compilado (padrão: programa_cshort.txt)
+*/
+int main(int argc, char *argv[])
 {
-    if ((fd = fopen("programa_cshort.txt", "r")) == NULL)
+    const char *arquivo = "programa_cshort.txt";
+    bool pre_analise = false;
+    int num_threads = 1;
+    NIVEL_RASTRO nivel = RASTRO_DESLIGADO;
+    const char *saida_rastro = NULL;
+    size_t tam_anel = 0;
+    bool estatisticas = false;
+    const char *arquivo_csb = NULL;
+    bool csb_com_linhas = true;
+    bool executar = false;
+    bool otimizar = true;
+    const char *csb_a_executar = NULL;
+    OPCOES_EXECUCAO opcoes_execucao = {0};
+    FLUXO_TOKENS fluxo;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--pre-analex") == 0) pre_analise = true;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            pre_analise = true;
+            num_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--rastro") == 0 && i + 1 < argc)
+        {
+            const char *nome = argv[++i];
+            if (strcmp(nome, "tokens") == 0) nivel = RASTRO_TOKENS;
+            else if (strcmp(nome, "arvore") == 0) nivel = RASTRO_ARVORE;
+            else if (strcmp(nome, "desligado") == 0) nivel = RASTRO_DESLIGADO;
+            else
+            {
+                printf("Erro: nivel de rastro '%s' desconhecido (use desligado, tokens ou arvore).\n", nome);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--estatisticas") == 0) estatisticas = true;
+        else if (strcmp(argv[i], "--tabela-passo-a-passo") == 0) tabelaPassoAPasso(true);
+        else if (strcmp(argv[i], "--log-tabela") == 0 && i + 1 < argc)
+        {
+            if (!abrirLogTabela(argv[++i]))
+            {
+                printf("Erro: nao foi possivel criar '%s'.\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--instantaneos-tabela") == 0 && i + 1 < argc)
+        {
+            if (!abrirInstantaneosTabela(argv[++i]))
+            {
+                printf("Erro: nao foi possivel criar '%s'.\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--rastro-saida") == 0 && i + 1 < argc) saida_rastro = argv[++i];
+        else if (strcmp(argv[i], "--rastro-anel") == 0 && i + 1 < argc) tam_anel = (size_t)atol(argv[++i]) * 1024;
+        else if (strcmp(argv[i], "--csb") == 0 && i + 1 < argc) arquivo_csb = argv[++i];
+        else if (strcmp(argv[i], "--csb-sem-linhas") == 0) csb_com_linhas = false;
+        else if ((strcmp(argv[i], "--desmontar") == 0 || strcmp(argv[i], "--desmontar-detalhado") == 0) && i + 1 < argc)
+        {
+            bool detalhes = strcmp(argv[i], "--desmontar-detalhado") == 0;
+            IMAGEM_CSB imagem;
+            if (!carregar_imagem(argv[++i], &imagem)) return 1;
+            desmontar_imagem(stdout, &imagem, detalhes);
+            liberar_imagem(&imagem);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--sem-otimizacao") == 0) otimizar = false;
+        else if (strcmp(argv[i], "--sem-regra") == 0 && i + 1 < argc)
+        {
+            if (!ativa_regra_peephole(argv[++i], false))
+            {
+                printf("Erro: regra do peephole '%s' desconhecida (veja --regras-peephole).\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--regras-peephole") == 0)
+        {
+            lista_regras_peephole(stdout);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--executar") == 0) executar = true;
+        else if (strcmp(argv[i], "--executar-csb") == 0 && i + 1 < argc) csb_a_executar = argv[++i];
+        else if (strcmp(argv[i], "--pilha") == 0 && i + 1 < argc) opcoes_execucao.tam_pilha = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-instrucoes") == 0 && i + 1 < argc) opcoes_execucao.max_instrucoes = atoll(argv[++i]);
+        else arquivo = argv[i];
+    }
+
+    if (csb_a_executar != NULL)
+    {
+        IMAGEM_CSB imagem;
+        RESULTADO_EXECUCAO resultado;
+        if (!carregar_imagem(csb_a_executar, &imagem)) return 1;
+        executar_imagem(&imagem, "main", &opcoes_execucao, &resultado);
+        relatorio_execucao(stdout, &imagem, &resultado);
+        liberar_imagem(&imagem);
+        return resultado.ok ? 0 : 1;
+    }
+
+    if ((fd = fopen(arquivo, "r")) == NULL)
     {
-        printf("Erro: Arquivo de entrada 'programa_cshort.txt' nao encontrado.\n");
-        return;
+        printf("Erro: Arquivo de entrada '%s' nao encontrado.\n", arquivo);
+        return 1;
+    }
+
+    // Carrega a fonte inteira em memória (mmap); se falhar, o Analex continua lendo com fgetc
+    carregar_fonte(fd);
+
+    // Opcionalmente, todos os tokens são lidos de uma vez e o parser anda por índice
+    if (pre_analise)
+    {
+        if (pre_analex_paralelo(fd, &fluxo, num_threads)) usar_fluxo_de_tokens(&fluxo);
+        else printf("Aviso: nao foi possivel pre-analisar o arquivo; usando o Analex sob demanda.\n");
+    }
+
+    if (!abrir_rastro(nivel, saida_rastro, tam_anel))
+    {
+        printf("Erro: nao foi possivel abrir o rastro em '%s'.\n", saida_rastro ? saida_rastro : "stdout");
+        return 1;
     }
 
     printf("Iniciando analise sintatica...\n");
     printf("-------------------------------------------\n");
 
     // Adicionamos um cabeçalho para o fluxo de tokens
-    printf("FLUXO DE TOKENS CONSUMIDOS:\n");
+    if (nivel != RASTRO_DESLIGADO && saida_rastro == NULL) printf("FLUXO DE TOKENS CONSUMIDOS:\n");
 
     Prog(); // Ponto de partida da análise sintática
+    fechar_rastro();
 
     printf("\n-------------------------------------------\n");
     printf("Analise sintatica concluida com sucesso!\n");
+    if (estatisticas) relatorioTabela(stdout);
+
+    if (otimizar)
+    {
+        ESTATISTICAS_PEEPHOLE peephole;
+        ESTATISTICAS_DESVIOS desvios;
+        otimiza_peephole(&peephole);
+        otimiza_desvios(&desvios);
+        if (estatisticas)
+        {
+            relatorio_peephole(stdout, &peephole);
+            relatorio_desvios(stdout, &desvios);
+        }
+    }
 
     salvar_codigo_em_arquivo("codigo_maquina.txt");
+    if (arquivo_csb != NULL || executar)
+    {
+        IMAGEM_CSB imagem;
+        if (!montar_imagem(&imagem, csb_com_linhas)) return 1;
+        if (arquivo_csb != NULL)
+        {
+            if (!salvar_imagem(&imagem, arquivo_csb)) return 1;
+            printf("Imagem binaria salva em: %s\n", arquivo_csb);
+        }
+        if (executar)
+        {
+            RESULTADO_EXECUCAO resultado;
+            executar_imagem(&imagem, "main", &opcoes_execucao, &resultado);
+            relatorio_execucao(stdout, &imagem, &resultado);
+            if (!resultado.ok) return 1;
+        }
+        liberar_imagem(&imagem);
+    }
 
+    if (pre_analise) liberar_fluxo(&fluxo);
+    liberar_fonte();
+    liberar_nomes();
     fclose(fd);
-}
\ No newline at end of file
+    return 0;
+}
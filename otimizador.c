@@ -0,0 +1,372 @@
+/**
+ * @file otimizador.c
+ * @brief Implementação dos passes de otimização.
+ *
+ * O encadeamento de desvios não apaga instruções na hora: marca-as com `REMOVIDA`
+ * e, no fim, `compacta` fecha os buracos. Assim as posições continuam válidas
+ * enquanto o passe anda pelo código.
+ *
+ * O peephole reescreve o buffer no lugar, com um cursor de leitura e um de
+ * escrita: cada instrução lida é acrescentada à saída e as regras são tentadas
+ * sobre a janela do fim da saída, de novo e de novo enquanto alguma casar. Assim
+ * uma reescrita pode habilitar outra sobre instruções já emitidas (dobrar
+ * `1 + 2 * 3` inteiro, por exemplo).
+ *
+ * Os dois passes terminam em `remapeia`, que ajusta a tabela de linhas e o início
+ * das funções às novas posições.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "otimizador.h"
+#include "gerador_codigo.h"
+#include "analex.h"
+
+#define REMOVIDA NUM_OPCODES    ///< Opcode das instruções a serem descartadas por `compacta`.
+
+/** Posição de cada rótulo (-1 se ele não foi colocado), refeita a cada rodada. */
+static int *posicao_rotulo = NULL;
+static int cap_posicao_rotulo = 0;
+
+/** Vetor de n + 1 posições para um passe (a última é o fim do código). */
+static int *novas_posicoes(int n) {
+    int *nova_posicao = malloc(((size_t)n + 1) * sizeof(int));
+    if (nova_posicao == NULL) error("Memoria insuficiente para otimizar o codigo.");
+    return nova_posicao;
+}
+
+/**
+ * Ajusta as funções e a tabela de linhas depois que a instrução i passou para
+ * nova_posicao[i] (não decrescente) e sobraram k instruções. Libera nova_posicao.
+ */
+static void remapeia(int *nova_posicao, int k) {
+    for (int f = 0; f < codigo.num_funcoes; f++) {
+        codigo.funcoes[f].inicio = nova_posicao[codigo.funcoes[f].inicio];
+    }
+
+    // Uma entrada cujas instruções sumiram todas cai sobre a seguinte, que prevalece
+    int m = 0;
+    for (int l = 0; l < codigo.num_linhas; l++) {
+        LINHA_GERADA entrada = { nova_posicao[codigo.linhas[l].instrucao], codigo.linhas[l].linha };
+        if (entrada.instrucao >= k) break;
+        if (m > 0 && codigo.linhas[m - 1].instrucao == entrada.instrucao) m--;
+        if (m > 0 && codigo.linhas[m - 1].linha == entrada.linha) continue;
+        codigo.linhas[m++] = entrada;
+    }
+    codigo.num_linhas = m;
+
+    free(nova_posicao);
+}
+
+/** Fecha os buracos deixados pelas instruções REMOVIDA. */
+static void compacta() {
+    int n = codigo.quantidade;
+    int *nova_posicao = novas_posicoes(n);
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        nova_posicao[i] = k;
+        if (codigo.instrucoes[i].op != REMOVIDA) codigo.instrucoes[k++] = codigo.instrucoes[i];
+    }
+    nova_posicao[n] = k;
+    codigo.quantidade = k;
+    remapeia(nova_posicao, k);
+}
+
+/** Refaz posicao_rotulo a partir das instruções LABEL. */
+static void resolve_rotulos() {
+    if (codigo.num_rotulos > cap_posicao_rotulo) {
+        int *novo = realloc(posicao_rotulo, (size_t)codigo.num_rotulos * sizeof(int));
+        if (novo == NULL) error("Memoria insuficiente para otimizar o codigo.");
+        posicao_rotulo = novo;
+        cap_posicao_rotulo = codigo.num_rotulos;
+    }
+    for (int r = 0; r < codigo.num_rotulos; r++) posicao_rotulo[r] = -1;
+    for (int i = 0; i < codigo.quantidade; i++) {
+        if (codigo.instrucoes[i].op == OP_LABEL) posicao_rotulo[codigo.instrucoes[i].arg.rotulo] = i;
+    }
+}
+
+/** Primeira instrução a partir de i que não é um LABEL (ou codigo.quantidade). */
+static int pula_rotulos(int i) {
+    while (i < codigo.quantidade && codigo.instrucoes[i].op == OP_LABEL) i++;
+    return i;
+}
+
+/** Segue a cadeia de GOTOs a partir do rótulo r; devolve o primeiro rótulo do grupo onde ela termina. */
+static int destino_final(int r) {
+    // Cada passo troca de rótulo; mais passos que rótulos só acontecem em um ciclo de GOTOs
+    for (int passos = 0; passos < codigo.num_rotulos; passos++) {
+        if (posicao_rotulo[r] < 0) return r;
+        int i = pula_rotulos(posicao_rotulo[r]);
+        if (i == codigo.quantidade || codigo.instrucoes[i].op != OP_GOTO) break;
+        int proximo = codigo.instrucoes[i].arg.rotulo;
+        if (proximo == r || posicao_rotulo[proximo] < 0) break;
+        r = proximo;
+    }
+    // Rótulos vizinhos são fundidos no primeiro do grupo
+    int i = posicao_rotulo[r];
+    while (i > 0 && codigo.instrucoes[i - 1].op == OP_LABEL) i--;
+    return codigo.instrucoes[i].arg.rotulo;
+}
+
+/** Uma rodada do passe; devolve true se mudou alguma coisa. */
+static bool rodada_desvios(ESTATISTICAS_DESVIOS *estatisticas) {
+    bool mudou = false;
+    resolve_rotulos();
+
+    for (int i = 0; i < codigo.quantidade; i++) {
+        INSTRUCAO *instrucao = &codigo.instrucoes[i];
+        if (!e_desvio(instrucao->op)) continue;
+        if (posicao_rotulo[instrucao->arg.rotulo] < 0) continue;
+
+        int destino = destino_final(instrucao->arg.rotulo);
+        if (destino != instrucao->arg.rotulo) {
+            instrucao->arg.rotulo = destino;
+            estatisticas->desvios_encurtados++;
+            mudou = true;
+        }
+        if (instrucao->op != OP_GOTO) continue;
+
+        int alvo = pula_rotulos(posicao_rotulo[destino]);
+        if (posicao_rotulo[destino] > i && pula_rotulos(i + 1) == alvo) {
+            instrucao->op = REMOVIDA;
+            estatisticas->gotos_removidos++;
+            mudou = true;
+        } else if (alvo < codigo.quantidade && codigo.instrucoes[alvo].op == OP_RET) {
+            instrucao->op = OP_RET;
+            instrucao->arg.real = 0;
+            estatisticas->gotos_para_ret++;
+            mudou = true;
+        }
+    }
+
+    // Rótulos que nenhum desvio usa (posicao_rotulo vira contador de usos)
+    for (int r = 0; r < codigo.num_rotulos; r++) posicao_rotulo[r] = 0;
+    for (int i = 0; i < codigo.quantidade; i++) {
+        if (e_desvio(codigo.instrucoes[i].op)) posicao_rotulo[codigo.instrucoes[i].arg.rotulo]++;
+    }
+    for (int i = 0; i < codigo.quantidade; i++) {
+        if (codigo.instrucoes[i].op == OP_LABEL && posicao_rotulo[codigo.instrucoes[i].arg.rotulo] == 0) {
+            codigo.instrucoes[i].op = REMOVIDA;
+            estatisticas->rotulos_removidos++;
+            mudou = true;
+        }
+    }
+
+    compacta();
+    return mudou;
+}
+
+void otimiza_desvios(ESTATISTICAS_DESVIOS *estatisticas) {
+    memset(estatisticas, 0, sizeof(*estatisticas));
+    estatisticas->instrucoes_antes = codigo.quantidade;
+    while (rodada_desvios(estatisticas));
+    estatisticas->instrucoes_depois = codigo.quantidade;
+}
+
+void relatorio_desvios(FILE *saida, const ESTATISTICAS_DESVIOS *estatisticas) {
+    fprintf(saida, "\n=== Encadeamento de desvios ===\n");
+    fprintf(saida, "Desvios encurtados: %d\n", estatisticas->desvios_encurtados);
+    fprintf(saida, "GOTOs trocados por RET: %d\n", estatisticas->gotos_para_ret);
+    fprintf(saida, "GOTOs para a instrucao seguinte removidos: %d\n", estatisticas->gotos_removidos);
+    fprintf(saida, "Rotulos sem uso removidos: %d\n", estatisticas->rotulos_removidos);
+    fprintf(saida, "Instrucoes: %d -> %d\n", estatisticas->instrucoes_antes, estatisticas->instrucoes_depois);
+}
+
+/* ---------------------------------------------------------------------------
+ * Peephole
+ * ------------------------------------------------------------------------- */
+
+/**
+ * Uma regra: casa com as `tamanho` instruções a partir de `janela` e, se casar,
+ * reescreve-as no lugar. Devolve quantas instruções ficaram (no máximo `tamanho`),
+ * ou -1 se não casou.
+ */
+typedef struct {
+    const char *nome;
+    const char *padrao;
+    int tamanho;
+    int (*aplica)(INSTRUCAO *janela);
+} REGRA_PEEPHOLE;
+
+static bool eh_constante_numerica(const INSTRUCAO *instrucao) {
+    return instrucao->op == OP_PUSH_INT || instrucao->op == OP_PUSH_CHAR || instrucao->op == OP_PUSH_REAL;
+}
+
+/** A operação de uma instrução aritmética, inteira ou real, como IADD .. IDIV; NUM_OPCODES se não é uma. */
+static OPCODE operacao_aritmetica(OPCODE op) {
+    if (op >= OP_IADD && op <= OP_IDIV) return op;
+    if (op >= OP_FADD && op <= OP_FDIV) return (OPCODE)(OP_IADD + (op - OP_FADD));
+    return NUM_OPCODES;
+}
+
+static double real_da_constante(const INSTRUCAO *instrucao) {
+    return instrucao->op == OP_PUSH_REAL ? instrucao->arg.real : (double)instrucao->arg.inteiro;
+}
+
+/**
+ * PUSH a; PUSH b; op  =>  PUSH (a op b), com a mesma aritmética do interpretador. A
+ * instrução só é dobrada com constantes do seu tipo (as que o parser gera).
+ */
+static int dobra_constantes(INSTRUCAO *j) {
+    OPCODE op = operacao_aritmetica(j[2].op);
+    if (!eh_constante_numerica(&j[0]) || !eh_constante_numerica(&j[1]) || op == NUM_OPCODES) return -1;
+    bool real = j[0].op == OP_PUSH_REAL || j[1].op == OP_PUSH_REAL;
+    if (j[2].op >= OP_IADD && j[2].op <= OP_IDIV && real) return -1;
+    if (j[2].op >= OP_FADD && j[2].op <= OP_FDIV && (j[0].op != OP_PUSH_REAL || j[1].op != OP_PUSH_REAL)) return -1;
+    if (!real) {
+        uint32_t a = (uint32_t)j[0].arg.inteiro, b = (uint32_t)j[1].arg.inteiro;
+        int resultado;
+        switch (op) {
+            case OP_IADD: resultado = (int)(a + b); break;
+            case OP_ISUB: resultado = (int)(a - b); break;
+            case OP_IMUL: resultado = (int)(a * b); break;
+            default:
+                if (b == 0) return -1; // Fica para dar o erro de execução
+                resultado = (int)b == -1 ? (int)(0u - a) : (int)a / (int)b;
+                break;
+        }
+        j[0].op = OP_PUSH_INT;
+        j[0].arg.inteiro = resultado;
+    } else {
+        double a = real_da_constante(&j[0]), b = real_da_constante(&j[1]), resultado;
+        switch (op) {
+            case OP_IADD: resultado = a + b; break;
+            case OP_ISUB: resultado = a - b; break;
+            case OP_IMUL: resultado = a * b; break;
+            default: resultado = a / b; break;
+        }
+        j[0].op = OP_PUSH_REAL;
+        j[0].arg.real = resultado;
+    }
+    return 1;
+}
+
+/** x; PUSH 0; IADD|ISUB  e  x; PUSH 1; IMUL|IDIV  =>  x */
+static int elemento_neutro(INSTRUCAO *j) {
+    if (j[0].op != OP_PUSH_INT) return -1;
+    OPCODE op = operacao_aritmetica(j[1].op);
+    if (j[0].arg.inteiro == 0 && (op == OP_IADD || op == OP_ISUB)) return 0;
+    if (j[0].arg.inteiro == 1 && (op == OP_IMUL || op == OP_IDIV)) return 0;
+    return -1;
+}
+
+/** PUSH c; GOFALSE L  =>  GOTO L (c == 0) ou nada (c != 0); GOTRUE, ao contrário */
+static int desvio_constante(INSTRUCAO *j) {
+    if (j[1].op != OP_GOFALSE && j[1].op != OP_GOTRUE) return -1;
+    bool falso;
+    switch (j[0].op) {
+        case OP_PUSH_INT: case OP_PUSH_CHAR: falso = j[0].arg.inteiro == 0; break;
+        case OP_PUSH_REAL: falso = j[0].arg.real == 0.0; break;
+        case OP_PUSH_STR: falso = false; break;
+        default: return -1;
+    }
+    if (falso != (j[1].op == OP_GOFALSE)) return 0;
+    j[0].op = OP_GOTO;
+    j[0].arg.rotulo = j[1].arg.rotulo;
+    return 1;
+}
+
+/** RET|GOTO; x  =>  RET|GOTO, para x que não é um LABEL (nada desvia para x) */
+static int codigo_morto(INSTRUCAO *j) {
+    if (j[0].op != OP_RET && j[0].op != OP_GOTO) return -1;
+    if (j[1].op == OP_LABEL) return -1;
+    return 1;
+}
+
+/** PUSH|LOAD_G|LOAD_L|DUP; POP  =>  nada (o valor de um comando-expressão como `x;` ou `5;`) */
+static int empilha_descarta(INSTRUCAO *j) {
+    if (j[1].op != OP_POP) return -1;
+    switch (j[0].op) {
+        case OP_PUSH_INT: case OP_PUSH_REAL: case OP_PUSH_CHAR: case OP_PUSH_STR:
+        case OP_LOAD_G: case OP_LOAD_L: case OP_DUP:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+static const REGRA_PEEPHOLE regras[] = {
+    { "dobra-constantes",  "PUSH a; PUSH b; [I|F]ADD..DIV => PUSH (a op b)",     3, dobra_constantes },
+    { "elemento-neutro",   "PUSH 0; IADD|ISUB => -   PUSH 1; IMUL|IDIV => -",    2, elemento_neutro },
+    { "desvio-constante",  "PUSH c; GOFALSE|GOTRUE L => GOTO L ou -",            2, desvio_constante },
+    { "codigo-morto",      "RET|GOTO; x => RET|GOTO (x nao e LABEL)",            2, codigo_morto },
+    { "empilha-descarta",  "PUSH|LOAD_G|LOAD_L|DUP; POP => -",                   2, empilha_descarta },
+};
+
+#define NUM_REGRAS ((int)(sizeof(regras) / sizeof(regras[0])))
+_Static_assert(sizeof(regras) / sizeof(regras[0]) <= MAX_REGRAS_PEEPHOLE, "aumente MAX_REGRAS_PEEPHOLE");
+
+/** Regras desligadas por ativa_regra_peephole. */
+static bool desligada[NUM_REGRAS];
+
+bool ativa_regra_peephole(const char *nome, bool ativa) {
+    for (int r = 0; r < NUM_REGRAS; r++) {
+        if (strcmp(regras[r].nome, nome) == 0) {
+            desligada[r] = !ativa;
+            return true;
+        }
+    }
+    return false;
+}
+
+void otimiza_peephole(ESTATISTICAS_PEEPHOLE *estatisticas) {
+    memset(estatisticas, 0, sizeof(*estatisticas));
+    int n = codigo.quantidade;
+    estatisticas->instrucoes_antes = n;
+
+    // Onde começa cada função: as janelas não descem abaixo do início da função atual
+    bool *inicio_funcao = calloc((size_t)n + 1, sizeof(bool));
+    int *nova_posicao = novas_posicoes(n);
+    if (inicio_funcao == NULL) error("Memoria insuficiente para otimizar o codigo.");
+    for (int f = 0; f < codigo.num_funcoes; f++) inicio_funcao[codigo.funcoes[f].inicio] = true;
+
+    INSTRUCAO *saida = codigo.instrucoes;
+    int k = 0, piso = 0;
+    for (int i = 0; i < n; i++) {
+        if (inicio_funcao[i]) piso = k;
+        nova_posicao[i] = k;
+        saida[k++] = codigo.instrucoes[i];
+
+        // Tenta as regras sobre o fim da saída até nenhuma casar
+        bool casou = true;
+        while (casou) {
+            casou = false;
+            for (int r = 0; r < NUM_REGRAS && !casou; r++) {
+                if (desligada[r] || k - regras[r].tamanho < piso) continue;
+                INSTRUCAO *janela = &saida[k - regras[r].tamanho];
+                int restantes = regras[r].aplica(janela);
+                if (restantes < 0) continue;
+                k -= regras[r].tamanho - restantes;
+                estatisticas->disparos[r]++;
+                casou = true;
+            }
+        }
+    }
+    nova_posicao[n] = k;
+    codigo.quantidade = k;
+
+    // Uma reescrita pode apagar instruções anteriores: a posição de uma instrução
+    // não pode passar da posição das que vêm depois dela
+    for (int i = n - 1; i >= 0; i--) {
+        if (nova_posicao[i] > nova_posicao[i + 1]) nova_posicao[i] = nova_posicao[i + 1];
+    }
+    remapeia(nova_posicao, k);
+    free(inicio_funcao);
+    estatisticas->instrucoes_depois = k;
+}
+
+void lista_regras_peephole(FILE *saida) {
+    for (int r = 0; r < NUM_REGRAS; r++) {
+        fprintf(saida, "%-18s %-52s %s\n", regras[r].nome, regras[r].padrao, desligada[r] ? "(desligada)" : "");
+    }
+}
+
+void relatorio_peephole(FILE *saida, const ESTATISTICAS_PEEPHOLE *estatisticas) {
+    fprintf(saida, "\n=== Peephole ===\n");
+    for (int r = 0; r < NUM_REGRAS; r++) {
+        fprintf(saida, "%-18s %d%s\n", regras[r].nome, estatisticas->disparos[r], desligada[r] ? " (desligada)" : "");
+    }
+    fprintf(saida, "Instrucoes: %d -> %d\n", estatisticas->instrucoes_antes, estatisticas->instrucoes_depois);
+}
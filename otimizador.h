@@ -0,0 +1,73 @@
+/**
+ * @file otimizador.h
+ * @brief Passes de otimização sobre o código gerado (o buffer `codigo` de gerador_codigo.h).
+ *
+ * Os passes rodam depois que o programa inteiro foi gerado e reescrevem as
+ * instruções no lugar: a tabela de linhas e o início das funções são ajustados
+ * junto, de modo que o código otimizado continua pronto para salvar, montar em
+ * uma imagem .csb ou executar.
+ */
+
+#ifndef _OTIMIZADOR_
+#define _OTIMIZADOR_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define MAX_REGRAS_PEEPHOLE 32  ///< Limite da tabela de regras do peephole.
+
+/** @brief O que `otimiza_desvios` fez. */
+typedef struct {
+    int desvios_encurtados;     ///< Desvios redirecionados para o destino final de uma cadeia de GOTOs.
+    int gotos_para_ret;         ///< GOTOs para um RET trocados pelo próprio RET.
+    int gotos_removidos;        ///< GOTOs para a instrução seguinte.
+    int rotulos_removidos;      ///< Rótulos que nenhum desvio usa mais (inclusive os fundidos com um vizinho).
+    int instrucoes_antes;
+    int instrucoes_depois;
+} ESTATISTICAS_DESVIOS;
+
+/**
+ * @brief Encadeamento de desvios.
+ *
+ * Resolve a posição de cada rótulo e:
+ * - redireciona desvios para rótulos seguidos de GOTO direto para o destino final da cadeia;
+ * - funde rótulos vizinhos (os desvios passam a usar o primeiro deles);
+ * - troca `GOTO Ln` por `RET` quando Ln leva a um RET;
+ * - remove `GOTO` para a instrução seguinte e os rótulos que ficaram sem uso.
+ *
+ * Repete até nada mais mudar.
+ */
+void otimiza_desvios(ESTATISTICAS_DESVIOS *estatisticas);
+
+/** @brief Escreve o relatório de `otimiza_desvios`. */
+void relatorio_desvios(FILE *saida, const ESTATISTICAS_DESVIOS *estatisticas);
+
+/** @brief O que `otimiza_peephole` fez. */
+typedef struct {
+    int disparos[MAX_REGRAS_PEEPHOLE];  ///< Vezes que cada regra foi aplicada (na ordem da tabela).
+    int instrucoes_antes;
+    int instrucoes_depois;
+} ESTATISTICAS_PEEPHOLE;
+
+/**
+ * @brief Otimizador peephole: reescreve sequências curtas de instruções segundo uma tabela de regras.
+ *
+ * As regras olham uma janela de até 3 instruções consecutivas, nunca atravessam
+ * o início de uma função e só casam com instruções de uma mesma sequência reta
+ * (um LABEL não casa com nenhum padrão). `lista_regras_peephole` mostra a tabela.
+ */
+void otimiza_peephole(ESTATISTICAS_PEEPHOLE *estatisticas);
+
+/**
+ * @brief Liga ou desliga uma regra do peephole pelo nome.
+ * @return false se não existe regra com esse nome.
+ */
+bool ativa_regra_peephole(const char *nome, bool ativa);
+
+/** @brief Escreve as regras do peephole (nome, padrão, ligada ou não). */
+void lista_regras_peephole(FILE *saida);
+
+/** @brief Escreve quantas vezes cada regra foi aplicada. */
+void relatorio_peephole(FILE *saida, const ESTATISTICAS_PEEPHOLE *estatisticas);
+
+#endif // _OTIMIZADOR_
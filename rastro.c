@@ -0,0 +1,161 @@
+/**
+ * @file rastro.c
+ * @brief Implementação do rastro do analisador sintático.
+ *
+ * Cada linha do rastro é montada em um buffer local e entregue de uma vez a
+ * `escreve`, que a passa para o FILE* de destino (com um buffer grande, no caso
+ * de arquivo) ou a copia para o anel circular.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rastro.h"
+
+#define TAM_BUFFER_ARQUIVO (1024 * 1024) ///< Buffer do FILE* quando o destino é um arquivo.
+#define TAM_MAX_LINHA 256               ///< Maior linha do rastro (sem contar a indentação).
+#define ESPACOS_POR_NIVEL 2
+
+NIVEL_RASTRO nivel_rastro = RASTRO_DESLIGADO;
+
+/** Estado do destino do rastro. */
+static struct {
+    FILE *arquivo;          ///< Destino final (stdout ou o arquivo aberto).
+    bool arquivo_proprio;   ///< true se o arquivo foi aberto aqui (e deve ser fechado).
+    char *buffer;           ///< Buffer entregue a setvbuf para o arquivo.
+    int profundidade;       ///< Profundidade atual da árvore.
+    bool saida_registrada;  ///< fechar_rastro já foi registrada com atexit.
+
+    char *anel;             ///< Anel circular (NULL quando o rastro vai direto para o arquivo).
+    size_t tam_anel;
+    size_t pos_anel;        ///< Próxima posição a ser escrita no anel.
+    bool anel_deu_volta;    ///< true se o anel já foi sobrescrito ao menos uma vez.
+} rastro;
+
+/** Entrega bytes ao destino: direto no FILE* ou copiados para o anel. */
+static void escreve(const char *texto, size_t n) {
+    if (rastro.anel == NULL) {
+        fwrite(texto, 1, n, rastro.arquivo);
+        return;
+    }
+    while (n > 0) {
+        size_t trecho = rastro.tam_anel - rastro.pos_anel;
+        if (trecho > n) trecho = n;
+        memcpy(rastro.anel + rastro.pos_anel, texto, trecho);
+        rastro.pos_anel += trecho;
+        texto += trecho;
+        n -= trecho;
+        if (rastro.pos_anel == rastro.tam_anel) {
+            rastro.pos_anel = 0;
+            rastro.anel_deu_volta = true;
+        }
+    }
+}
+
+/** Escreve a indentação da profundidade atual, em blocos de espaços. */
+static void indenta() {
+    static const char espacos[] = "                                                                ";
+    size_t n = (size_t)rastro.profundidade * ESPACOS_POR_NIVEL;
+    while (n > 0) {
+        size_t trecho = n < sizeof(espacos) - 1 ? n : sizeof(espacos) - 1;
+        escreve(espacos, trecho);
+        n -= trecho;
+    }
+}
+
+/** Escreve uma linha completa (indentação + texto + '\n'). */
+static void escreve_linha(const char *linha, int n) {
+    if (n < 0) return;
+    if (n > TAM_MAX_LINHA - 1) n = TAM_MAX_LINHA - 1;
+    indenta();
+    escreve(linha, (size_t)n);
+    escreve("\n", 1);
+}
+
+bool abrir_rastro(NIVEL_RASTRO nivel, const char *arquivo, size_t tam_anel) {
+    fechar_rastro();
+    if (nivel == RASTRO_DESLIGADO) return true;
+
+    rastro.arquivo = stdout;
+    if (arquivo != NULL) {
+        rastro.arquivo = fopen(arquivo, "w");
+        if (rastro.arquivo == NULL) return false;
+        rastro.arquivo_proprio = true;
+        rastro.buffer = malloc(TAM_BUFFER_ARQUIVO);
+        if (rastro.buffer != NULL) setvbuf(rastro.arquivo, rastro.buffer, _IOFBF, TAM_BUFFER_ARQUIVO);
+    }
+    if (tam_anel > 0) {
+        rastro.anel = malloc(tam_anel);
+        if (rastro.anel == NULL) {
+            fechar_rastro();
+            return false;
+        }
+        rastro.tam_anel = tam_anel;
+    }
+
+    // Garante que o rastro saia mesmo quando error() encerra a compilação com exit
+    if (!rastro.saida_registrada) {
+        atexit(fechar_rastro);
+        rastro.saida_registrada = true;
+    }
+    rastro.profundidade = 0;
+    nivel_rastro = nivel;
+    return true;
+}
+
+void fechar_rastro() {
+    nivel_rastro = RASTRO_DESLIGADO;
+
+    if (rastro.anel != NULL) {
+        if (rastro.anel_deu_volta) {
+            fprintf(rastro.arquivo, "... (inicio do rastro descartado; ultimos %zu bytes)\n", rastro.tam_anel);
+            fwrite(rastro.anel + rastro.pos_anel, 1, rastro.tam_anel - rastro.pos_anel, rastro.arquivo);
+        }
+        fwrite(rastro.anel, 1, rastro.pos_anel, rastro.arquivo);
+        free(rastro.anel);
+        rastro.anel = NULL;
+    }
+    if (rastro.arquivo_proprio) {
+        fclose(rastro.arquivo);
+        free(rastro.buffer);
+    } else if (rastro.arquivo != NULL) {
+        fflush(rastro.arquivo);
+    }
+
+    bool registrada = rastro.saida_registrada;
+    memset(&rastro, 0, sizeof(rastro));
+    rastro.saida_registrada = registrada;
+}
+
+void rastro_abre_regra(const char *regra) {
+    char linha[TAM_MAX_LINHA];
+    escreve_linha(linha, snprintf(linha, sizeof(linha), "<%s>", regra));
+    rastro.profundidade++;
+}
+
+void rastro_fecha_regra(const char *regra) {
+    char linha[TAM_MAX_LINHA];
+    if (rastro.profundidade > 0) rastro.profundidade--;
+    escreve_linha(linha, snprintf(linha, sizeof(linha), "</%s>", regra));
+}
+
+void rastro_folha(const TOKEN *tk) {
+    char linha[TAM_MAX_LINHA];
+    int n;
+    switch (tk->cat) {
+        case ID: n = snprintf(linha, sizeof(linha), "- ID: %s", texto_nome(tk->nome)); break;
+        case SN: n = snprintf(linha, sizeof(linha), "- SN: %d", tk->codigo); break;
+        case CT_INT: n = snprintf(linha, sizeof(linha), "- CT_INT: %d", tk->valInt); break;
+        case CT_REAL: n = snprintf(linha, sizeof(linha), "- CT_REAL: %f", tk->valReal); break;
+        case CT_CHAR: n = snprintf(linha, sizeof(linha), "- CT_CHAR: '%c'", tk->valInt); break;
+        case CT_STRING: n = snprintf(linha, sizeof(linha), "- CT_STRING: \"%s\"", texto_nome(tk->nome)); break;
+        case PALAVRA_RESERVADA: n = snprintf(linha, sizeof(linha), "- PR: %d", tk->codigo); break;
+        default: n = snprintf(linha, sizeof(linha), "- TOKEN (cat %d)", tk->cat); break;
+    }
+    escreve_linha(linha, n);
+}
+
+void rastro_mensagem(const char *mensagem) {
+    char linha[TAM_MAX_LINHA];
+    escreve_linha(linha, snprintf(linha, sizeof(linha), "%s", mensagem));
+}
@@ -0,0 +1,69 @@
+/**
+ * @file rastro.h
+ * @brief Rastro do analisador sintático: a árvore de regras e os tokens consumidos.
+ *
+ * O parser chama as macros `ABRE_REGRA`, `FECHA_REGRA`, `FOLHA` e `MENSAGEM_RASTRO`
+ * em cada regra da gramática. Com o rastro desligado (o padrão), cada macro custa
+ * só uma comparação com `nivel_rastro`, marcada como improvável para o preditor de
+ * desvios; compilando com `-DSEM_RASTRO`, as macros somem do código.
+ *
+ * Ligado, o rastro escreve em um destino com buffer: a saída padrão, um arquivo ou
+ * um anel em memória que guarda só os últimos bytes e é despejado no fim da
+ * execução (inclusive quando `error` encerra a compilação). A indentação da árvore
+ * é um contador de profundidade, sem operações de string.
+ */
+
+#ifndef _RASTRO_
+#define _RASTRO_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "analex.h"
+
+/** @brief O que o rastro imprime. */
+typedef enum {
+    RASTRO_DESLIGADO, ///< Nada (padrão).
+    RASTRO_TOKENS,    ///< Só os tokens consumidos pelo parser, um por linha.
+    RASTRO_ARVORE     ///< A árvore sintática: `<Regra>` ... `</Regra>`, com os tokens como folhas.
+} NIVEL_RASTRO;
+
+/** @brief Nível atual; só deve ser mudado por `abrir_rastro` e `fechar_rastro`. */
+extern NIVEL_RASTRO nivel_rastro;
+
+/**
+ * @brief Liga o rastro.
+ * @param nivel O nível desejado (`RASTRO_DESLIGADO` não faz nada).
+ * @param arquivo Arquivo de destino, ou NULL para a saída padrão.
+ * @param tam_anel Se maior que 0, guarda só os últimos `tam_anel` bytes em memória e os escreve no destino no fim.
+ * @return false se o arquivo ou o anel não puderam ser criados (o rastro fica desligado).
+ */
+bool abrir_rastro(NIVEL_RASTRO nivel, const char *arquivo, size_t tam_anel);
+
+/** @brief Esvazia o anel ou o buffer no destino e desliga o rastro. Chamada também na saída do programa. */
+void fechar_rastro();
+
+/** @brief Imprime `<regra>` e aumenta a profundidade. Use `ABRE_REGRA`. */
+void rastro_abre_regra(const char *regra);
+
+/** @brief Diminui a profundidade e imprime `</regra>`. Use `FECHA_REGRA`. */
+void rastro_fecha_regra(const char *regra);
+
+/** @brief Imprime um token como folha da árvore (ou como linha do nível `RASTRO_TOKENS`). Use `FOLHA`. */
+void rastro_folha(const TOKEN *tk);
+
+/** @brief Imprime uma linha de texto livre na profundidade atual. Use `MENSAGEM_RASTRO`. */
+void rastro_mensagem(const char *mensagem);
+
+#ifdef SEM_RASTRO
+#define ABRE_REGRA(regra) ((void)0)
+#define FECHA_REGRA(regra) ((void)0)
+#define FOLHA(tk) ((void)0)
+#define MENSAGEM_RASTRO(mensagem) ((void)0)
+#else
+#define ABRE_REGRA(regra) do { if (__builtin_expect(nivel_rastro == RASTRO_ARVORE, 0)) rastro_abre_regra(regra); } while (0)
+#define FECHA_REGRA(regra) do { if (__builtin_expect(nivel_rastro == RASTRO_ARVORE, 0)) rastro_fecha_regra(regra); } while (0)
+#define FOLHA(tk) do { if (__builtin_expect(nivel_rastro != RASTRO_DESLIGADO, 0)) rastro_folha(&(tk)); } while (0)
+#define MENSAGEM_RASTRO(mensagem) do { if (__builtin_expect(nivel_rastro == RASTRO_ARVORE, 0)) rastro_mensagem(mensagem); } while (0)
+#endif
+
+#endif // _RASTRO_
@@ -0,0 +1,158 @@
+/**
+ * @file tabela_nomes.c
+ * @brief Implementação da Tabela de Nomes.
+ *
+ * Cada nome tem uma entrada nos vetores `texto`, `tamanho` e `hash`, indexados
+ * pelo código do nome. A busca usa uma tabela hash de endereçamento aberto
+ * (sondagem linear) que guarda `código + 1` em cada posição (0 = posição livre).
+ * Os textos são copiados para blocos grandes de memória, alocados sob demanda.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tabela_nomes.h"
+#include "analex.h"
+
+#define TAM_BLOCO_NOMES (64 * 1024) ///< Tamanho de cada bloco de textos.
+#define SLOTS_INICIAIS 1024         ///< Tamanho inicial da tabela hash (potência de 2).
+
+/** Estado da Tabela de Nomes. */
+static struct {
+    int quantidade;         ///< Número de nomes internados.
+    int capacidade;         ///< Posições reservadas nos vetores por nome.
+    const char **texto;     ///< Texto de cada nome.
+    int *tamanho;           ///< Tamanho de cada nome.
+    unsigned int *hash;     ///< Hash de cada nome (evita recalcular ao crescer a tabela hash).
+
+    int *slots;             ///< Tabela hash: código + 1, ou 0 se livre.
+    int num_slots;          ///< Tamanho da tabela hash (potência de 2).
+
+    char **blocos;          ///< Blocos onde os textos estão guardados.
+    int num_blocos;
+    int cap_blocos;
+    size_t usado;           ///< Bytes já ocupados no último bloco.
+} nomes;
+
+/** Hash FNV-1a do texto. */
+static unsigned int hash_texto(const char *texto, int tamanho) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < tamanho; i++) {
+        h = (h ^ (unsigned char)texto[i]) * 16777619u;
+    }
+    return h;
+}
+
+/** Aborta a compilação por falta de memória. */
+static void sem_memoria() {
+    error("Memoria insuficiente para a tabela de nomes.");
+}
+
+/**
+ * @brief Copia um texto para o bloco atual, abrindo um bloco novo se ele não couber.
+ * @return O endereço da cópia, terminada em '\0'.
+ */
+static const char *guarda_texto(const char *texto, int tamanho) {
+    size_t necessario = (size_t)tamanho + 1;
+    if (nomes.num_blocos == 0 || nomes.usado + necessario > TAM_BLOCO_NOMES) {
+        if (nomes.num_blocos == nomes.cap_blocos) {
+            int nova = nomes.cap_blocos ? nomes.cap_blocos * 2 : 8;
+            char **blocos = realloc(nomes.blocos, nova * sizeof(*blocos));
+            if (blocos == NULL) sem_memoria();
+            nomes.blocos = blocos;
+            nomes.cap_blocos = nova;
+        }
+        size_t tam_bloco = necessario > TAM_BLOCO_NOMES ? necessario : TAM_BLOCO_NOMES;
+        char *bloco = malloc(tam_bloco);
+        if (bloco == NULL) sem_memoria();
+        nomes.blocos[nomes.num_blocos++] = bloco;
+        nomes.usado = 0;
+    }
+    char *copia = nomes.blocos[nomes.num_blocos - 1] + nomes.usado;
+    memcpy(copia, texto, tamanho);
+    copia[tamanho] = '\0';
+    nomes.usado += necessario;
+    return copia;
+}
+
+/** Dobra a tabela hash e reinsere todos os códigos. */
+static void cresce_slots() {
+    int novo_num = nomes.num_slots ? nomes.num_slots * 2 : SLOTS_INICIAIS;
+    int *slots = calloc(novo_num, sizeof(*slots));
+    if (slots == NULL) sem_memoria();
+    for (int nome = 0; nome < nomes.quantidade; nome++) {
+        unsigned int i = nomes.hash[nome] & (novo_num - 1);
+        while (slots[i] != 0) i = (i + 1) & (novo_num - 1);
+        slots[i] = nome + 1;
+    }
+    free(nomes.slots);
+    nomes.slots = slots;
+    nomes.num_slots = novo_num;
+}
+
+/** Garante espaço para mais um nome nos vetores indexados pelo código. */
+static void cresce_vetores() {
+    if (nomes.quantidade < nomes.capacidade) return;
+    int nova = nomes.capacidade ? nomes.capacidade * 2 : 512;
+    const char **texto = realloc(nomes.texto, nova * sizeof(*texto));
+    if (texto) nomes.texto = texto;
+    int *tamanho = realloc(nomes.tamanho, nova * sizeof(*tamanho));
+    if (tamanho) nomes.tamanho = tamanho;
+    unsigned int *hash = realloc(nomes.hash, nova * sizeof(*hash));
+    if (hash) nomes.hash = hash;
+    if (!texto || !tamanho || !hash) sem_memoria();
+    nomes.capacidade = nova;
+}
+
+/**
+ * @brief Interna um texto e devolve seu código.
+ *
+ * Algoritmo:
+ * 1. Calcula o hash do texto e sonda a tabela hash a partir de `hash & (num_slots - 1)`.
+ * 2. Se encontrar um nome com o mesmo hash, tamanho e texto, devolve o código dele.
+ * 3. Se chegar a uma posição livre, copia o texto para um bloco, cria o código novo
+ *    e o grava nessa posição. A tabela dobra quando passa de metade ocupada.
+ */
+int interna_nome(const char *texto, int tamanho) {
+    if (nomes.num_slots == 0 || 2 * (nomes.quantidade + 1) > nomes.num_slots) cresce_slots();
+
+    unsigned int h = hash_texto(texto, tamanho);
+    unsigned int i = h & (nomes.num_slots - 1);
+    while (nomes.slots[i] != 0) {
+        int nome = nomes.slots[i] - 1;
+        if (nomes.hash[nome] == h && nomes.tamanho[nome] == tamanho && memcmp(nomes.texto[nome], texto, tamanho) == 0) {
+            return nome;
+        }
+        i = (i + 1) & (nomes.num_slots - 1);
+    }
+
+    cresce_vetores();
+    int nome = nomes.quantidade++;
+    nomes.texto[nome] = guarda_texto(texto, tamanho);
+    nomes.tamanho[nome] = tamanho;
+    nomes.hash[nome] = h;
+    nomes.slots[i] = nome + 1;
+    return nome;
+}
+
+const char *texto_nome(int nome) {
+    return nomes.texto[nome];
+}
+
+int tamanho_nome(int nome) {
+    return nomes.tamanho[nome];
+}
+
+int quantidade_nomes() {
+    return nomes.quantidade;
+}
+
+void liberar_nomes() {
+    for (int i = 0; i < nomes.num_blocos; i++) free(nomes.blocos[i]);
+    free(nomes.blocos);
+    free(nomes.texto);
+    free(nomes.tamanho);
+    free(nomes.hash);
+    free(nomes.slots);
+    memset(&nomes, 0, sizeof(nomes));
+}
@@ -0,0 +1,41 @@
+/**
+ * @file tabela_nomes.h
+ * @brief Interface da Tabela de Nomes (internação de identificadores e literais).
+ *
+ * O Analex guarda aqui o texto de cada identificador e de cada constante string
+ * e entrega ao resto do compilador apenas um número: o código do nome.
+ * Textos iguais recebem sempre o mesmo código, então a Tabela de Símbolos, o
+ * parser e o gerador de código comparam nomes com um `==` entre inteiros, e
+ * existe uma única cópia de cada texto durante toda a compilação.
+ *
+ * Os textos ficam em blocos que nunca são realocados: o ponteiro devolvido por
+ * `texto_nome` continua válido até `liberar_nomes`.
+ */
+
+#ifndef _TABELA_NOMES_
+#define _TABELA_NOMES_
+
+/** @brief Código usado quando um token não tem nome associado. */
+#define SEM_NOME (-1)
+
+/**
+ * @brief Interna um texto e devolve seu código.
+ * @param texto Início do texto (não precisa terminar em '\0').
+ * @param tamanho Quantidade de caracteres do texto.
+ * @return O código do nome: o mesmo para textos iguais, começando em 0.
+ */
+int interna_nome(const char *texto, int tamanho);
+
+/** @brief Devolve o texto (terminado em '\0') de um nome internado. @param nome O código do nome. */
+const char *texto_nome(int nome);
+
+/** @brief Devolve a quantidade de caracteres de um nome internado. @param nome O código do nome. */
+int tamanho_nome(int nome);
+
+/** @brief Devolve quantos nomes diferentes já foram internados. */
+int quantidade_nomes();
+
+/** @brief Libera todos os nomes. Os códigos e ponteiros entregues antes deixam de valer. */
+void liberar_nomes();
+
+#endif // _TABELA_NOMES_
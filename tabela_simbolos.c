@@ -12,11 +12,176 @@
 #include <stdlib.h>
 #include <string.h>
 #include "tabela_simbolos.h"
+#include "tabela_nomes.h"
 #include "analex.h"
 
 /** A instância global da tabela de símbolos, acessível por todo o módulo. */
 Tabela tabela;
 
+#define SLOTS_INICIAIS_ESCOPO 256 ///< Tamanho inicial da tabela hash de nomes declarados (potência de 2).
+#define ENTRADAS_INICIAIS 256     ///< Capacidade inicial da pilha de entradas.
+
+/**
+ * Tabela hash de endereçamento aberto (sondagem linear), indexada pelo código do nome.
+ * Cada posição guarda `nome + 1` (0 = livre) e a posição na pilha da declaração mais
+ * recente desse nome (-1 se todas já saíram de escopo). Um nome que entra na hash
+ * nunca sai dela, então não há remoções nem marcas de "apagado".
+ */
+static struct {
+    int *chave;     ///< Código do nome + 1, ou 0 se a posição está livre.
+    int *cabeca;    ///< Declaração mais recente do nome (início da cadeia em `tabela.sombra`).
+    int num_slots;  ///< Tamanho da tabela (potência de 2).
+    int ocupados;   ///< Nomes distintos guardados.
+} escopo;
+
+/** Espalha o código do nome (hash de Fibonacci); códigos vizinhos caem longe um do outro. */
+static unsigned int hash_nome(int nome) {
+    unsigned int h = (unsigned int)nome * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+/** Dobra a tabela hash e reposiciona os nomes já guardados. */
+static void cresce_escopo() {
+    int novo = escopo.num_slots ? escopo.num_slots * 2 : SLOTS_INICIAIS_ESCOPO;
+    int *chave = calloc(novo, sizeof(int));
+    int *cabeca = malloc(novo * sizeof(int));
+    if (chave == NULL || cabeca == NULL) error("Memoria insuficiente para a tabela de simbolos.");
+
+    for (int i = 0; i < escopo.num_slots; i++) {
+        if (escopo.chave[i] == 0) continue;
+        unsigned int s = hash_nome(escopo.chave[i] - 1) & (novo - 1);
+        while (chave[s] != 0) s = (s + 1) & (novo - 1);
+        chave[s] = escopo.chave[i];
+        cabeca[s] = escopo.cabeca[i];
+    }
+    free(escopo.chave);
+    free(escopo.cabeca);
+    escopo.chave = chave;
+    escopo.cabeca = cabeca;
+    escopo.num_slots = novo;
+}
+
+/**
+ * @brief Encontra a posição do nome na tabela hash.
+ * @param nome O código do nome.
+ * @param criar Se true, reserva uma posição (com cadeia vazia) quando o nome ainda não está lá.
+ * @return O índice da posição, ou -1 se o nome não está na tabela e `criar` é false.
+ */
+static int slot_do_nome(int nome, bool criar) {
+    if (criar && 2 * (escopo.ocupados + 1) > escopo.num_slots) cresce_escopo();
+    if (escopo.num_slots == 0) return -1;
+
+    unsigned int mascara = escopo.num_slots - 1;
+    unsigned int s = hash_nome(nome) & mascara;
+    while (escopo.chave[s] != 0) {
+        if (escopo.chave[s] == nome + 1) return s;
+        s = (s + 1) & mascara;
+    }
+    if (!criar) return -1;
+    escopo.chave[s] = nome + 1;
+    escopo.cabeca[s] = -1;
+    escopo.ocupados++;
+    return s;
+}
+
+#define TAM_BUFFER_LOG (1024 * 1024) ///< Buffer de cada arquivo de log da tabela.
+
+/** Eventos registrados no log da tabela (ver `abrirLogTabela`). */
+typedef enum {
+    EV_INSERIR,   ///< Nova entrada sem declaração anterior do mesmo nome.
+    EV_SOMBREAR,  ///< Nova entrada que sombreia uma declaração anterior do mesmo nome (viva ou zumbi).
+    EV_MATAR,     ///< Parâmetro marcado como zumbi no fim da função.
+    EV_RETIRAR    ///< Entrada removida do topo na saída de um escopo.
+} EVENTO_TABELA;
+
+static const char *T_evento[] = {
+    [EV_INSERIR] = "inserir",
+    [EV_SOMBREAR] = "sombrear",
+    [EV_MATAR] = "matar",
+    [EV_RETIRAR] = "retirar"
+};
+
+/** Destinos da depuração da tabela; todos desligados por padrão. */
+static struct {
+    FILE *eventos;          ///< Log de eventos (uma linha TSV por evento), ou NULL.
+    FILE *instantaneos;     ///< Instantâneos da tabela (uma linha JSON cada), ou NULL.
+    bool passo_a_passo;     ///< Imprime a tabela e espera um Enter a cada evento (o comportamento antigo).
+    long num_instantaneo;   ///< Quantos instantâneos já foram escritos.
+} depuracao;
+
+/** Abre um arquivo de log com um buffer grande; devolve NULL se não conseguir. */
+static FILE *abre_log(const char *arquivo) {
+    FILE *f = fopen(arquivo, "w");
+    if (f != NULL) {
+        char *buffer = malloc(TAM_BUFFER_LOG); // Vive até o fim do processo, quando exit() esvazia o arquivo
+        if (buffer != NULL) setvbuf(f, buffer, _IOFBF, TAM_BUFFER_LOG);
+    }
+    return f;
+}
+
+/**
+ * @brief Registra um evento da tabela: uma linha no log de eventos, se houver,
+ * e a tabela inteira na tela, se o modo passo a passo estiver ligado.
+ *
+ * @param evento O que aconteceu.
+ * @param pos A posição da entrada afetada (para `EV_RETIRAR`, a posição que ela ocupava).
+ */
+static void registra_evento(EVENTO_TABELA evento, int pos) {
+    if (depuracao.eventos != NULL) {
+        TokenInfo *e = &tabela.tokensTab[pos];
+        fprintf(depuracao.eventos, "%s\t%d\t%s\t%s\t%s\t%s\t%d\t%d\t%d\n", T_evento[evento], pos, texto_nome(e->nome),
+                T_escopo[e->escopo], T_IdCategoria[e->idcategoria], T_tipo[e->tipo], tabela.sombra[pos], tabela.geracao[pos], contLinha);
+    }
+    if (depuracao.passo_a_passo) {
+        printarTabela(pos);
+        printf("Pressione Enter para continuar...\n");
+        getchar();
+    }
+}
+
+/** Dobra a pilha de entradas (e os vetores `sombra` e `geracao`, que andam junto). */
+static void cresce_tabela() {
+    int nova = tabela.capacidade ? tabela.capacidade * 2 : ENTRADAS_INICIAIS;
+    TokenInfo *tokens = realloc(tabela.tokensTab, nova * sizeof(TokenInfo));
+    if (tokens == NULL) error("Memoria insuficiente para a tabela de simbolos.");
+    tabela.tokensTab = tokens;
+    int *sombra = realloc(tabela.sombra, nova * sizeof(int));
+    if (sombra == NULL) error("Memoria insuficiente para a tabela de simbolos.");
+    tabela.sombra = sombra;
+    int *geracao = realloc(tabela.geracao, nova * sizeof(int));
+    if (geracao == NULL) error("Memoria insuficiente para a tabela de simbolos.");
+    tabela.geracao = geracao;
+    tabela.capacidade = nova;
+}
+
+/**
+ * @brief Tira a entrada `pos` da cadeia de declarações do seu nome.
+ *
+ * Quase sempre ela é a cabeça da cadeia (o topo da pilha, ou um parâmetro que
+ * morre antes dos locais da função saírem, que não podem ter o mesmo nome);
+ * o caso geral só percorre as declarações vivas desse nome. O `sombra` da
+ * própria entrada é mantido, para o histórico.
+ */
+static void desencadeia(int pos) {
+    int s = slot_do_nome(tabela.tokensTab[pos].nome, false);
+    if (escopo.cabeca[s] == pos) {
+        escopo.cabeca[s] = tabela.sombra[pos];
+        return;
+    }
+    for (int i = escopo.cabeca[s]; i >= 0; i = tabela.sombra[i]) {
+        if (tabela.sombra[i] == pos) {
+            tabela.sombra[i] = tabela.sombra[pos];
+            return;
+        }
+    }
+}
+
+/** @return A declaração viva mais recente do nome, ou -1. */
+static int cabeca_do_nome(int nome) {
+    int s = slot_do_nome(nome, false);
+    return s < 0 ? -1 : escopo.cabeca[s];
+}
+
 /** Vetor de strings para mapear o enum de escopo para texto legível. */
 char *T_escopo[] = {
     [GLOBAL] = "Global",
@@ -55,41 +220,52 @@ char *T_zumbi[] = {
  *
  * Algoritmo:
  * 1. Chama a função `buscaDeclRep` para garantir que o símbolo não está sendo redeclarado ilegalmente.
- * 2. Adiciona a estrutura `TokenInfo` fornecida na próxima posição livre da tabela (o topo da pilha).
- * 3. Incrementa o ponteiro do topo (`tabela.topo`), efetivamente "empilhando" o novo símbolo.
- * 4. Chama `printarTabela` para depuração, mostrando o estado atual da tabela.
+ * 2. Adiciona a estrutura `TokenInfo` fornecida na próxima posição livre da tabela (o topo da pilha),
+ *    dobrando a capacidade da pilha quando ela está cheia.
+ * 3. Coloca a nova entrada no início da cadeia do seu nome (ela passa a sombrear a declaração
+ *    anterior) e a marca com a geração do seu escopo; inserir um PROC abre uma nova geração.
+ * 4. Incrementa o ponteiro do topo (`tabela.topo`), efetivamente "empilhando" o novo símbolo.
+ * 5. Registra o evento (`inserir` ou `sombrear`) para depuração.
  *
  * @param token A estrutura contendo todas as informações do símbolo a ser inserido.
  */
 void inserirNaTabela(TokenInfo token){
     buscaDeclRep(token); // Verifica Repetição de lexema
+    if (tabela.topo == tabela.capacidade) cresce_tabela();
+    int s = slot_do_nome(token.nome, true);
     tabela.tokensTab[tabela.topo] = token;
+    tabela.sombra[tabela.topo] = escopo.cabeca[s];
+    tabela.geracao[tabela.topo] = token.escopo == GLOBAL ? 0 : tabela.geracao_atual;
+    if (token.idcategoria == PROC) tabela.geracao_atual++; // Parâmetros e locais que vêm a seguir são da nova função
+    escopo.cabeca[s] = tabela.topo;
     tabela.topo++;
-    printarTabela(-1);
+    if (tabela.topo > tabela.pico) tabela.pico = tabela.topo;
+    registra_evento(tabela.sombra[tabela.topo - 1] >= 0 ? EV_SOMBREAR : EV_INSERIR, tabela.topo - 1);
 }
 
 /**
  * @brief Busca por declarações repetidas de um mesmo identificador.
  *
  * Algoritmo:
- * Realiza uma varredura linear (O(n)) em toda a tabela. Para cada entrada,
- * compara o lexema (nome) com o do novo token. Se os nomes forem iguais,
- * aplica regras específicas para determinar se é uma redeclaração ilegal
- * (ex: duas variáveis globais com o mesmo nome, ou dois parâmetros vivos
- * no mesmo escopo). Se uma redeclaração ilegal for encontrada, a função
- * `error` é chamada para encerrar a compilação.
+ * Percorre só a cadeia de declarações vivas do nome do novo token (a hash leva
+ * à mais recente e `tabela.sombra` às anteriores), em vez da tabela inteira.
+ * Zumbis já saíram da cadeia; nenhuma das regras abaixo as acusaria mesmo.
+ * Para cada uma, aplica regras específicas para determinar se é uma
+ * redeclaração ilegal (ex: duas variáveis globais com o mesmo nome, ou dois
+ * parâmetros vivos no mesmo escopo). Se uma redeclaração ilegal for
+ * encontrada, a função `error` é chamada para encerrar a compilação.
  *
  * @param token As informações do novo símbolo que está sendo declarado.
  */
 void buscaDeclRep(TokenInfo token){
-    for(int i = 0; i < tabela.topo; i++){
-        if(strcmp(token.lexema, tabela.tokensTab[i].lexema) == 0){
-            if(tabela.tokensTab[i].idcategoria == PROC && token.idcategoria == PROC) error("Redeclaração de procedimento encontrada");
-            if(tabela.tokensTab[i].idcategoria == VAR_LOCAL && token.idcategoria == VAR_LOCAL) error("Redeclaração de variável encontrada");
-            if(tabela.tokensTab[i].idcategoria == VAR_GLOBAL && token.idcategoria == VAR_GLOBAL) error("Redeclaração de variável global encontrada");
-            // A condição de "zumbi" impede que parâmetros de escopos antigos causem erro de redeclaração.
-            if(tabela.tokensTab[i].zumbi == VIVO && strcmp(token.lexema, tabela.tokensTab[i].lexema) == 0) error("Redeclaração de parâmetro encontrada");
-        }
+    for(int i = cabeca_do_nome(token.nome); i >= 0; i = tabela.sombra[i]){
+        if(tabela.tokensTab[i].idcategoria == PROC && token.idcategoria == PROC) error("Redeclaração de procedimento encontrada");
+        // Um protótipo só é repetido pela definição (ou por outro protótipo) da mesma função
+        if(tabela.tokensTab[i].idcategoria == PROT_ && token.idcategoria == PROC) continue;
+        if(tabela.tokensTab[i].idcategoria == VAR_LOCAL && token.idcategoria == VAR_LOCAL) error("Redeclaração de variável encontrada");
+        if(tabela.tokensTab[i].idcategoria == VAR_GLOBAL && token.idcategoria == VAR_GLOBAL) error("Redeclaração de variável global encontrada");
+        // A condição de "zumbi" impede que parâmetros de escopos antigos causem erro de redeclaração.
+        if(tabela.tokensTab[i].zumbi == VIVO) error("Redeclaração de parâmetro encontrada");
     }
 }
 
@@ -97,18 +273,19 @@ void buscaDeclRep(TokenInfo token){
  * @brief Busca a posição da declaração mais recente de um lexema.
  *
  * Algoritmo:
- * Realiza uma busca linear (O(n)) na tabela, mas começando do fim (`tabela.topo-1`)
- * para o início. Esta abordagem de "pilha" é essencial para o tratamento de escopos.
- * Ela garante que a declaração mais próxima (mais "no topo da pilha") seja encontrada
- * primeiro (ex: uma variável local antes de uma global com o mesmo nome).
- * Símbolos marcados como "ZUMBI_" são ignorados, pois estão fora de escopo.
- *
- * @param lexema O nome (string) do identificador a ser buscado.
- * @return O índice do lexema na tabela se encontrado e ativo; -1 caso contrário.
- */
-int buscaLexPos(char *lexema){
-    for(int i = tabela.topo - 1; i >= 0; i--){
-        if(strcmp(lexema, tabela.tokensTab[i].lexema) == 0 && tabela.tokensTab[i].zumbi != ZUMBI_){
+ * A hash dá, em O(1), a declaração mais recente do nome; a cadeia `tabela.sombra`
+ * segue para as anteriores, da mais "no topo da pilha" para a mais antiga. Isso
+ * preserva o comportamento de pilha essencial para o tratamento de escopos: a
+ * declaração mais próxima (ex: uma variável local antes de uma global com o mesmo
+ * nome) é encontrada primeiro. Símbolos marcados como "ZUMBI_" estão fora de
+ * escopo: `matarZumbis` os tira da cadeia, então a busca nem passa por eles.
+ *
+ * @param nome O código do nome do identificador a ser buscado.
+ * @return O índice do nome na tabela se encontrado e ativo; -1 caso contrário.
+ */
+int buscaLexPos(int nome){
+    for(int i = cabeca_do_nome(nome); i >= 0; i = tabela.sombra[i]){
+        if(tabela.tokensTab[i].zumbi != ZUMBI_){
             return i;
         }
     }
@@ -121,8 +298,8 @@ int buscaLexPos(char *lexema){
  * Esta é uma função de depuração visual. Ela percorre a tabela de símbolos
  * e imprime colunas selecionadas de cada entrada, usando os vetores de
  * mapeamento (ex: `T_escopo`) para exibir texto em vez de números.
- * A chamada `getchar()` ao final pausa a execução, permitindo que o
- * desenvolvedor analise o estado da tabela passo a passo.
+ * No modo passo a passo (`tabelaPassoAPasso`), ela é chamada a cada evento,
+ * seguida de uma pausa que espera um Enter.
  *
  * @param pos Posição a ser destacada (atualmente não utilizado, -1 por padrão).
  */
@@ -139,7 +316,7 @@ void printarTabela(int pos) {
 
     for (int i = 0; i < tabela.topo; i++) {
         aux = tabela.tokensTab[i];
-        printf("| %-30s|", aux.lexema);
+        printf("| %-30.30s|", texto_nome(aux.nome));
         printf(" %-9s|", T_escopo[aux.escopo]);
         printf(" %-10s|", T_IdCategoria[aux.idcategoria]);
         printf(" %-6s|", T_tipo[aux.tipo]);
@@ -148,19 +325,20 @@ void printarTabela(int pos) {
     }
 
     printf("+-------------------------------+----------+-----------+-------+-------+\n");
-    printf("Pressione Enter para continuar...\n");
-    getchar();
 }
 
 /**
  * @brief Remove o elemento do topo da tabela de símbolos (operação de "pop").
  *
- * Esta é uma função de baixo nível que simplesmente decrementa o ponteiro
- * do topo da pilha, efetivamente removendo o último símbolo inserido.
+ * Esta é uma função de baixo nível que decrementa o ponteiro do topo da pilha,
+ * efetivamente removendo o último símbolo inserido, e devolve o início da cadeia
+ * do seu nome à declaração que ele sombreava.
  */
 void removerDaTabela(){
     if (tabela.topo > 0) {
         tabela.topo--;
+        if (tabela.tokensTab[tabela.topo].zumbi == VIVO) desencadeia(tabela.topo); // Zumbis já saíram da cadeia
+        registra_evento(EV_RETIRAR, tabela.topo);
     } else {
         printf("Tabela já está vazia.\n");
     }
@@ -169,12 +347,15 @@ void removerDaTabela(){
 /**
  * @brief Apaga todo o conteúdo da tabela de símbolos.
  *
- * Utiliza `memset` para zerar a memória do vetor de tokens e redefine o
- * topo para 0, restaurando a tabela ao seu estado inicial.
+ * Redefine o topo para 0 e zera a hash de nomes, restaurando a tabela ao seu
+ * estado inicial. A memória já reservada é mantida para a próxima compilação,
+ * e o pico (`tabela.pico`) continua valendo para o processo inteiro.
  */
 void limparTabela() {
-    memset(tabela.tokensTab, 0, sizeof(tabela.tokensTab));
     tabela.topo = 0;
+    tabela.geracao_atual = 0;
+    if (escopo.num_slots > 0) memset(escopo.chave, 0, escopo.num_slots * sizeof(int));
+    escopo.ocupados = 0;
 }
 
 /**
@@ -183,26 +364,27 @@ void limparTabela() {
  */
 void resetTokenInfo(TokenInfo *token) {
     memset(token, 0, sizeof(TokenInfo));
-    memset(token->lexema, 0, sizeof(token->lexema));
 }
 
 /**
  * @brief Marca os parâmetros de uma função como "zumbis" ao sair de seu escopo.
  *
  * Algoritmo:
- * Ao final da análise do corpo de uma função, seus parâmetros se tornam inacessíveis.
- * Esta função percorre os parâmetros associados à função (`procPos`) e muda seu
- * status para `ZUMBI_`. Isso os "desativa" para futuras buscas de nome, mas mantém
+ * Ao final da análise do corpo de uma função (ou de um protótipo), seus parâmetros se tornam inacessíveis.
+ * Esta função percorre os parâmetros associados à função (`procPos`), muda seu
+ * status para `ZUMBI_` e os tira da cadeia do seu nome. Isso os "desativa" para
+ * futuras buscas de nome (que passam a custar só os símbolos vivos), mas mantém
  * suas informações na tabela para outras possíveis análises do compilador.
  *
  * @param procPos O índice inicial do procedimento na tabela.
  */
 void matarZumbis(int procPos){
     procPos++;
-    while(1){
+    while(procPos < tabela.topo){
         if(tabela.tokensTab[procPos].idcategoria != PROC_PAR) break;
         tabela.tokensTab[procPos].zumbi = ZUMBI_;
-        printarTabela(procPos);
+        desencadeia(procPos);
+        registra_evento(EV_MATAR, procPos);
         procPos++;
     }
 }
@@ -211,19 +393,60 @@ void matarZumbis(int procPos){
  * @brief Remove todas as variáveis locais do escopo atual.
  *
  * Algoritmo:
- * Implementa a operação de "saída de escopo". A função olha para o símbolo no topo
- * da pilha da tabela. Se for uma variável local (`VAR_LOCAL`), ela o remove
- * chamando `removerDaTabela()`. O processo se repete até que o topo da pilha
- * não seja mais uma variável local, efetivamente limpando todo o escopo local.
+ * Implementa a operação de "saída de escopo". A função desce a partir do topo da
+ * pilha enquanto encontra variáveis locais (`VAR_LOCAL`) e remove todas elas de
+ * uma vez com `restaurarEscopo`, efetivamente limpando todo o escopo local.
+ * Quem guardou uma marca com `marcarEscopo` pode chamar `restaurarEscopo` direto.
  */
 void retirarLocais(){
-    while(1){
-        if(tabela.tokensTab[tabela.topo-1].idcategoria != VAR_LOCAL) break;
+    int marca = tabela.topo;
+    while(marca > 0 && tabela.tokensTab[marca-1].idcategoria == VAR_LOCAL) marca--;
+    restaurarEscopo(marca);
+}
+
+/**
+ * @brief Marca o início de um escopo.
+ *
+ * A marca é só a altura atual da pilha; guardá-la custa O(1) e dispensa
+ * examinar as categorias das entradas na saída do escopo (como faz `retirarLocais`).
+ *
+ * @return A altura atual da pilha.
+ */
+int marcarEscopo(){
+    return tabela.topo;
+}
+
+/**
+ * @brief Sai de um escopo, removendo tudo o que foi inserido depois da marca.
+ *
+ * Cada remoção é um `removerDaTabela`, que devolve a cadeia do nome removido à
+ * declaração que ele sombreava; o custo é proporcional aos símbolos do escopo.
+ *
+ * @param marca A altura devolvida por `marcarEscopo` na entrada do escopo.
+ */
+void restaurarEscopo(int marca){
+    while(tabela.topo > marca){
         removerDaTabela();
-        printarTabela(-1);
     }
 }
 
+/**
+ * @brief Escreve a marca d'água da tabela: o maior número de entradas vivas ao
+ * mesmo tempo e a memória reservada pela pilha (`tokensTab`, `sombra` e `geracao`)
+ * e pela hash de nomes (`chave` e `cabeca`).
+ *
+ * @param saida O arquivo onde escrever (ex: stdout).
+ */
+void relatorioTabela(FILE *saida){
+    size_t bytes_pilha = (size_t)tabela.capacidade * sizeof(*tabela.tokensTab)
+                       + (size_t)tabela.capacidade * sizeof(*tabela.sombra)
+                       + (size_t)tabela.capacidade * sizeof(*tabela.geracao);
+    size_t bytes_hash = (size_t)escopo.num_slots * sizeof(*escopo.chave)
+                      + (size_t)escopo.num_slots * sizeof(*escopo.cabeca);
+    fprintf(saida, "Tabela de simbolos: pico de %d entradas; %d reservadas (%zu KB) e hash de nomes com %d posicoes (%zu KB).\n",
+            tabela.pico, tabela.capacidade, bytes_pilha / 1024, escopo.num_slots, bytes_hash / 1024);
+}
+
 /**
  * @brief Busca por um símbolo e retorna sua estrutura de dados completa.
  *
@@ -231,11 +454,73 @@ void retirarLocais(){
  * de busca e, se o símbolo não for encontrado (`pos < 0`), ela dispara um erro fatal.
  * Caso contrário, retorna a estrutura `TokenInfo` do símbolo encontrado.
  *
- * @param lexema O nome do identificador a ser buscado.
+ * @param nome O código do nome do identificador a ser buscado.
  * @return A estrutura TokenInfo completa do símbolo encontrado.
  */
-TokenInfo buscaDecl(char *lexema){
-    int pos = buscaLexPos(lexema);
+TokenInfo buscaDecl(int nome){
+    int pos = buscaLexPos(nome);
     if(pos < 0)  error("Declaração não encontrada");
     return tabela.tokensTab[pos];
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Liga o log de eventos da tabela.
+ *
+ * Cada inserção, sombreamento, morte de parâmetro e remoção vira uma linha
+ * separada por tabulações: `evento posicao nome escopo classe tipo sombra geracao linha`,
+ * onde `sombra` é a posição da declaração viva anterior do mesmo nome (-1 se não há),
+ * `geracao` é a do escopo da entrada (0 = global) e `linha` é a linha do código-fonte.
+ * A primeira linha do arquivo é o cabeçalho.
+ *
+ * @param arquivo O arquivo a ser criado.
+ * @return false se o arquivo não pôde ser criado.
+ */
+bool abrirLogTabela(const char *arquivo){
+    depuracao.eventos = abre_log(arquivo);
+    if (depuracao.eventos == NULL) return false;
+    fprintf(depuracao.eventos, "evento\tposicao\tnome\tescopo\tclasse\ttipo\tsombra\tgeracao\tlinha\n");
+    return true;
+}
+
+/**
+ * @brief Liga os instantâneos da tabela, escritos por `instantaneoTabela`.
+ * @param arquivo O arquivo a ser criado (JSON Lines: um objeto por instantâneo).
+ * @return false se o arquivo não pôde ser criado.
+ */
+bool abrirInstantaneosTabela(const char *arquivo){
+    depuracao.instantaneos = abre_log(arquivo);
+    return depuracao.instantaneos != NULL;
+}
+
+/**
+ * @brief Liga ou desliga o modo passo a passo: a tabela inteira é impressa a cada
+ * evento e a execução espera um Enter. Desligado por padrão.
+ */
+void tabelaPassoAPasso(bool ligado){
+    depuracao.passo_a_passo = ligado;
+}
+
+/**
+ * @brief Grava o estado atual da tabela como uma linha JSON, se os instantâneos estiverem ligados.
+ *
+ * Formato: `{"n":1,"momento":"fim_funcao","nome":"f","linha":12,"topo":3,"entradas":[{"pos":0,"nome":"x",...}]}`,
+ * com os mesmos campos do log de eventos em cada entrada, mais `zumbi`. Como as zumbis
+ * continuam na pilha, cada instantâneo traz o histórico completo das declarações.
+ *
+ * @param momento Onde o instantâneo foi tirado (ex: "fim_funcao", "fim_programa").
+ * @param nome O código do nome da função correspondente, ou SEM_NOME.
+ */
+void instantaneoTabela(const char *momento, int nome){
+    FILE *f = depuracao.instantaneos;
+    if (f == NULL) return;
+
+    fprintf(f, "{\"n\":%ld,\"momento\":\"%s\",\"nome\":\"%s\",\"linha\":%d,\"topo\":%d,\"entradas\":[",
+            ++depuracao.num_instantaneo, momento, nome == SEM_NOME ? "" : texto_nome(nome), contLinha, tabela.topo);
+    for (int i = 0; i < tabela.topo; i++) {
+        TokenInfo *e = &tabela.tokensTab[i];
+        fprintf(f, "%s{\"pos\":%d,\"nome\":\"%s\",\"escopo\":\"%s\",\"classe\":\"%s\",\"tipo\":\"%s\",\"zumbi\":%d,\"sombra\":%d,\"geracao\":%d}",
+                i > 0 ? "," : "", i, texto_nome(e->nome), T_escopo[e->escopo], T_IdCategoria[e->idcategoria],
+                T_tipo[e->tipo], e->zumbi == ZUMBI_, tabela.sombra[i], tabela.geracao[i]);
+    }
+    fprintf(f, "]}\n");
+}
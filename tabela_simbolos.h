@@ -19,12 +19,15 @@
  * estado de "VIVO" para "ZUMBI_".
  *
  * 3. O Efeito:
- * - Um símbolo "ZUMBI_" é ignorado pela função de busca (`buscaLexPos`). Para
- * todos os efeitos, ele está fora de escopo e não pode ser encontrado ou
- * usado novamente.
- * - No entanto, ele permanece fisicamente na tabela. Isso preserva um
- * "histórico" completo de todas as declarações, o que é útil para depuração
- * e para entender a pilha de escopos em qualquer momento.
+ * - Um símbolo "ZUMBI_" sai da cadeia de declarações do seu nome (a que as
+ * buscas percorrem), então `buscaLexPos` e `buscaDeclRep` nunca mais o visitam.
+ * Para todos os efeitos, ele está fora de escopo e não pode ser encontrado ou
+ * usado novamente, e o custo das buscas depende só dos símbolos vivos, não de
+ * quantas funções vieram antes.
+ * - No entanto, ele permanece fisicamente na tabela, marcado com a geração do
+ * escopo em que foi declarado (`tabela.geracao`). Isso preserva um "histórico"
+ * completo de todas as declarações, o que é útil para depuração e para
+ * entender a pilha de escopos em qualquer momento (ver `instantaneoTabela`).
  *
  * A função `matarZumbis` é a responsável por aplicar este estado aos parâmetros
  * no final do escopo de uma função.
@@ -85,11 +88,13 @@ typedef enum {
  * de um identificador (seu nome, tipo, escopo, etc.).
  */
 typedef struct tokenInfo {
-    char lexema[31];        ///< O nome do identificador.
+    int nome;               ///< O código do nome do identificador na Tabela de Nomes (ver tabela_nomes.h).
     ESCOPO escopo;          ///< O escopo do identificador (GLOBAL ou LOCAL).
     TIPO tipo;              ///< O tipo de dado do identificador.
     IDCATEGORIA idcategoria;///< A categoria do identificador (variável, função, etc.).
     ZUMBI zumbi;            ///< O status de atividade do símbolo (VIVO ou ZUMBI_).
+    int endereco;           ///< Variáveis: índice no segmento de dados (globais) ou no quadro da função (locais e parâmetros).
+    int tamanho;            ///< Elementos de um vetor (0 = escalar; -1 = parâmetro vetor, sem tamanho conhecido).
 } TokenInfo;
 
 /**
@@ -98,10 +103,21 @@ typedef struct tokenInfo {
  * Funciona como uma pilha. O `topo` indica a próxima posição livre.
  * Novas entradas são adicionadas no topo, e a saída de escopo remove
  * entradas do topo.
+ *
+ * As buscas por nome não percorrem a pilha: uma tabela hash (interna a
+ * tabela_simbolos.c) leva cada nome à sua declaração viva mais recente, e
+ * `sombra` encadeia cada entrada à declaração anterior do mesmo nome
+ * (a que ela "sombreia"). Entradas zumbis saem da cadeia, mas guardam o
+ * seu `sombra` para os registros de depuração.
  */
 typedef struct tabela {
     int topo;                   ///< Ponteiro para o topo da pilha da tabela.
-    TokenInfo tokensTab[1024];  ///< O array que armazena todas as entradas da tabela.
+    int capacidade;             ///< Entradas reservadas em `tokensTab`, `sombra` e `geracao` (dobra quando enche).
+    int pico;                   ///< Maior `topo` já alcançado (marca d'água), ver `relatorioTabela`.
+    TokenInfo *tokensTab;       ///< O array que armazena todas as entradas da tabela.
+    int *sombra;                ///< Posição da declaração anterior com o mesmo nome, ou -1.
+    int *geracao;               ///< Geração do escopo de cada entrada: 0 no escopo global, k para a k-ésima função.
+    int geracao_atual;          ///< Geração dada às próximas entradas locais; cada PROC inserido abre uma nova.
 } Tabela;
 
 
@@ -154,8 +170,8 @@ void resetTokenInfo(TokenInfo *token);
 /** @brief Busca por declarações repetidas (redeclarações) de um símbolo. @param tokenInfo O símbolo a ser verificado. */
 void buscaDeclRep(TokenInfo tokenInfo);
 
-/** @brief Busca a posição da declaração mais recente de um símbolo. @param lexema O nome a ser buscado. @return O índice na tabela ou -1 se não encontrado. */
-int buscaLexPos(char *lexema);
+/** @brief Busca a posição da declaração mais recente de um símbolo. @param nome O código do nome a ser buscado. @return O índice na tabela ou -1 se não encontrado. */
+int buscaLexPos(int nome);
 
 /** @brief Marca os parâmetros de uma função como "zumbis" ao sair do escopo. @param procPos Posição da função. */
 void matarZumbis(int procPos);
@@ -163,8 +179,29 @@ void matarZumbis(int procPos);
 /** @brief Remove todas as variáveis locais do escopo atual (topo da pilha). */
 void retirarLocais();
 
-/** @brief Busca por um símbolo e retorna sua estrutura de dados. Dispara erro se não encontrar. @param lexema O nome a ser buscado. @return A estrutura TokenInfo do símbolo. */
-TokenInfo buscaDecl(char *lexema);
+/** @brief Marca o início de um escopo. @return A marca, a ser passada para `restaurarEscopo`. */
+int marcarEscopo();
+
+/** @brief Sai do escopo: remove tudo o que foi inserido depois da marca. @param marca O valor devolvido por `marcarEscopo`. */
+void restaurarEscopo(int marca);
+
+/** @brief Escreve o pico de entradas e a memória reservada pela tabela. @param saida Onde escrever. */
+void relatorioTabela(FILE *saida);
+
+/** @brief Liga o log de eventos da tabela (TSV, com buffer). @param arquivo O arquivo a ser criado. @return false se não pôde ser criado. */
+bool abrirLogTabela(const char *arquivo);
+
+/** @brief Liga os instantâneos da tabela (JSON Lines, com buffer). @param arquivo O arquivo a ser criado. @return false se não pôde ser criado. */
+bool abrirInstantaneosTabela(const char *arquivo);
+
+/** @brief Liga o modo passo a passo: a tabela é impressa a cada evento e a execução espera um Enter. */
+void tabelaPassoAPasso(bool ligado);
+
+/** @brief Grava um instantâneo da tabela, se ligados. @param momento Onde foi tirado. @param nome Código do nome da função, ou SEM_NOME. */
+void instantaneoTabela(const char *momento, int nome);
+
+/** @brief Busca por um símbolo e retorna sua estrutura de dados. Dispara erro se não encontrar. @param nome O código do nome a ser buscado. @return A estrutura TokenInfo do símbolo. */
+TokenInfo buscaDecl(int nome);
 
 
 #endif // _TABELA_SIMBOLOS_
\ No newline at end of file
@@ -0,0 +1,21 @@
+# Compila o analisador e executa cada programa de testes/casos, comparando a última linha que
+# importa da saída (o valor de retorno ou o erro) com o arquivo .esperado de mesmo nome.
+# Uso: sh testes/executa.sh
+cd "$(dirname "$0")/.." || exit 1
+sh compile.sh || exit 1
+
+RAIZ=$(pwd)
+SAIDAS=$(mktemp -d) || exit 1 # A execução grava codigo_maquina.txt no diretório corrente
+FALHAS=0
+for CASO in testes/casos/*.txt; do
+    ESPERADO=$(cat "${CASO%.txt}.esperado")
+    OBTIDO=$(cd "$SAIDAS" && "$RAIZ/analisador_cshort" --executar "$RAIZ/$CASO" 2>&1 | grep -E "^(Valor de retorno|Erro)" | tail -n 1)
+    if [ "$OBTIDO" = "$ESPERADO" ]; then
+        echo "ok      $CASO"
+    else
+        echo "FALHOU  $CASO: esperado '$ESPERADO', obtido '$OBTIDO'"
+        FALHAS=$((FALHAS + 1))
+    fi
+done
+rm -rf "$SAIDAS"
+[ $FALHAS -eq 0 ]